@@ -0,0 +1,403 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Copyright (C) 2013 David Faure <faure@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcommandlinediagnostics.h"
+#include "qcommandlinediagnostics_p.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+QCommandLineDiagnosticSink::~QCommandLineDiagnosticSink()
+{
+}
+
+static std::atomic<QCommandLineDiagnosticSink *> &globalSinkPointer()
+{
+    static std::atomic<QCommandLineDiagnosticSink *> sink(QCommandLineDiagnosticSink::defaultSink());
+    return sink;
+}
+
+/*!
+    Makes \a sink receive the warnings of all command line classes. The sink
+    is not owned and must outlive its use. Passing \c nullptr silences
+    diagnostics entirely.
+*/
+void QCommandLineDiagnosticSink::setGlobalSink(QCommandLineDiagnosticSink *sink)
+{
+    globalSinkPointer().store(sink, std::memory_order_release);
+}
+
+QCommandLineDiagnosticSink *QCommandLineDiagnosticSink::globalSink()
+{
+    return globalSinkPointer().load(std::memory_order_acquire);
+}
+
+/*!
+    Returns the sink installed at startup: a QCommandLineRingBufferSink
+    writing to stderr, drained on exit.
+*/
+QCommandLineDiagnosticSink *QCommandLineDiagnosticSink::defaultSink()
+{
+    // Leaked on purpose, so that warnings from static destructors still work.
+    static QCommandLineRingBufferSink *sink = new QCommandLineRingBufferSink;
+    return sink;
+}
+
+void qCommandLineWarning(std::initializer_list<std::string_view> parts)
+{
+    QCommandLineDiagnosticSink *sink = QCommandLineDiagnosticSink::globalSink();
+    if (!sink)
+        return;
+    std::string message;
+    for (const std::string_view &part : parts)
+        message.append(part.data(), part.size());
+    sink->warning(message);
+}
+
+class QCommandLineRingBufferSinkPrivate
+{
+public:
+    enum { MaximumMessageLength = 240 };
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        size_t length;
+        char text[MaximumMessageLength];
+    };
+
+    QCommandLineRingBufferSinkPrivate(FILE *output, size_t capacity, size_t maximumPerSecond);
+
+    bool admit();
+    bool push(std::string_view message);
+    void drain();
+    void run();
+    void startThread();
+    void reset();
+
+    FILE * const output;
+    const size_t mask;
+    const size_t maximumPerSecond;
+    std::unique_ptr<Cell[]> cells;
+    std::atomic<size_t> enqueuePosition;
+    std::atomic<size_t> dropped;
+    std::atomic<size_t> droppedTotal;
+
+    //! Second of the current rate limiting window and messages admitted in it.
+    std::atomic<int64_t> windowSecond;
+    std::atomic<size_t> windowCount;
+
+    //! Consumer side: only the drain thread and flush() take this mutex.
+    std::mutex drainMutex;
+    size_t dequeuePosition;
+
+    //! The drain thread, started on the first warning and again in a forked
+    //! child, which has no threads but the one that forked.
+    std::atomic<bool> threadRunning;
+    std::unique_ptr<std::thread> thread;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<bool> pending;
+    bool stopping;
+};
+
+static size_t roundUpToPowerOfTwo(size_t value)
+{
+    size_t result = 2;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+QCommandLineRingBufferSinkPrivate::QCommandLineRingBufferSinkPrivate(FILE *output, size_t capacity,
+                                                                     size_t maximumPerSecond)
+    : output(output),
+      mask(roundUpToPowerOfTwo(capacity) - 1),
+      maximumPerSecond(maximumPerSecond),
+      cells(new Cell[mask + 1]),
+      enqueuePosition(0),
+      dropped(0),
+      droppedTotal(0),
+      windowSecond(0),
+      windowCount(0),
+      dequeuePosition(0),
+      threadRunning(false),
+      pending(false),
+      stopping(false)
+{
+    for (size_t i = 0; i <= mask; ++i)
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool QCommandLineRingBufferSinkPrivate::admit()
+{
+    const int64_t second = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t current = windowSecond.load(std::memory_order_relaxed);
+    if (current != second && windowSecond.compare_exchange_strong(current, second, std::memory_order_relaxed))
+        windowCount.store(0, std::memory_order_relaxed);
+    return windowCount.fetch_add(1, std::memory_order_relaxed) < maximumPerSecond;
+}
+
+// Bounded multi-producer queue after Dmitry Vyukov: producers claim a cell
+// by advancing enqueuePosition and publish it through the cell sequence.
+bool QCommandLineRingBufferSinkPrivate::push(std::string_view message)
+{
+    size_t position = enqueuePosition.load(std::memory_order_relaxed);
+    Cell *cell;
+    for (;;) {
+        cell = &cells[position & mask];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const ptrdiff_t difference = ptrdiff_t(sequence) - ptrdiff_t(position);
+        if (difference == 0) {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if (difference < 0) {
+            return false; // full
+        } else {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    cell->length = std::min<size_t>(message.size(), MaximumMessageLength);
+    memcpy(cell->text, message.data(), cell->length);
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+void QCommandLineRingBufferSinkPrivate::drain()
+{
+    std::lock_guard<std::mutex> lock(drainMutex);
+    std::string batch;
+    for (;;) {
+        Cell &cell = cells[dequeuePosition & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+            break;
+        batch.append(cell.text, cell.length);
+        batch += '\n';
+        cell.sequence.store(dequeuePosition + mask + 1, std::memory_order_release);
+        ++dequeuePosition;
+    }
+    const size_t lost = dropped.exchange(0, std::memory_order_relaxed);
+    if (lost)
+        batch += "QCommandLineParser: " + std::to_string(lost) + " diagnostic messages dropped\n";
+    if (!batch.empty()) {
+        fwrite(batch.data(), 1, batch.size(), output);
+        fflush(output);
+    }
+}
+
+void QCommandLineRingBufferSinkPrivate::startThread()
+{
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    if (threadRunning.load(std::memory_order_relaxed))
+        return;
+    thread.reset(new std::thread([this] { run(); }));
+    threadRunning.store(true, std::memory_order_release);
+}
+
+// Forgets everything inherited from the parent in a forked child: the queued
+// warnings are the parent's to write, and its drain thread does not exist.
+void QCommandLineRingBufferSinkPrivate::reset()
+{
+    for (size_t i = 0; i <= mask; ++i)
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    enqueuePosition.store(0, std::memory_order_relaxed);
+    dequeuePosition = 0;
+    dropped.store(0, std::memory_order_relaxed);
+    (void)thread.release(); // cannot be joined or detached here
+    threadRunning.store(false, std::memory_order_relaxed);
+    pending.store(false, std::memory_order_relaxed);
+}
+
+#if !defined(_WIN32)
+// The live sinks, whose mutexes are held across fork() so that the child
+// never inherits one locked by a thread that does not exist there.
+static std::mutex &sinksMutex()
+{
+    static std::mutex *mutex = new std::mutex;
+    return *mutex;
+}
+
+static std::vector<QCommandLineRingBufferSinkPrivate *> &sinks()
+{
+    static std::vector<QCommandLineRingBufferSinkPrivate *> *list = new std::vector<QCommandLineRingBufferSinkPrivate *>;
+    return *list;
+}
+
+static void prepareFork()
+{
+    sinksMutex().lock();
+    for (QCommandLineRingBufferSinkPrivate *sink : sinks()) {
+        sink->drainMutex.lock();
+        sink->wakeMutex.lock();
+    }
+}
+
+static void resumeAfterFork(bool child)
+{
+    for (QCommandLineRingBufferSinkPrivate *sink : sinks()) {
+        if (child)
+            sink->reset();
+        sink->wakeMutex.unlock();
+        sink->drainMutex.unlock();
+    }
+    sinksMutex().unlock();
+}
+
+static void registerSink(QCommandLineRingBufferSinkPrivate *sink)
+{
+    static const int registered = pthread_atfork(prepareFork, [] { resumeAfterFork(false); },
+                                                 [] { resumeAfterFork(true); });
+    (void)registered;
+    std::lock_guard<std::mutex> lock(sinksMutex());
+    sinks().push_back(sink);
+}
+
+static void unregisterSink(QCommandLineRingBufferSinkPrivate *sink)
+{
+    std::lock_guard<std::mutex> lock(sinksMutex());
+    sinks().erase(std::find(sinks().begin(), sinks().end(), sink));
+}
+#else
+static void registerSink(QCommandLineRingBufferSinkPrivate *)
+{
+}
+
+static void unregisterSink(QCommandLineRingBufferSinkPrivate *)
+{
+}
+#endif
+
+void QCommandLineRingBufferSinkPrivate::run()
+{
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    while (!stopping) {
+        // The timeout covers a wake-up sent between the check and the wait.
+        wake.wait_for(lock, std::chrono::seconds(1), [this] { return stopping || pending.load(); });
+        pending.store(false);
+        lock.unlock();
+        // Let a burst of warnings collect into one write.
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        drain();
+        lock.lock();
+    }
+}
+
+/*!
+    Constructs a sink that queues up to \a capacity warnings in a lock-free
+    ring buffer and writes them to \a output from a background thread, in
+    batches and with a single flush per batch.
+
+    At most \a maximumPerSecond warnings are accepted per second; the rest,
+    and those arriving while the buffer is full, are counted as dropped and
+    summarized in the output. Reporting a warning never blocks and never
+    performs I/O on the calling thread.
+
+    The sink keeps working in a child created with fork(): the child writes
+    its own warnings from a new background thread, and leaves those queued
+    before the fork to the parent.
+*/
+QCommandLineRingBufferSink::QCommandLineRingBufferSink(FILE *output, size_t capacity, size_t maximumPerSecond)
+    : d(new QCommandLineRingBufferSinkPrivate(output, capacity, maximumPerSecond))
+{
+    registerSink(d);
+}
+
+QCommandLineRingBufferSink::~QCommandLineRingBufferSink()
+{
+    unregisterSink(d);
+    if (d->threadRunning.load(std::memory_order_acquire)) {
+        {
+            std::lock_guard<std::mutex> lock(d->wakeMutex);
+            d->stopping = true;
+        }
+        d->wake.notify_one();
+        d->thread->join();
+    }
+    d->drain();
+    delete d;
+}
+
+void QCommandLineRingBufferSink::warning(std::string_view message)
+{
+    if (!d->admit() || !d->push(message)) {
+        d->dropped.fetch_add(1, std::memory_order_relaxed);
+        d->droppedTotal.fetch_add(1, std::memory_order_relaxed);
+        // still wake the thread, which reports the drops
+    }
+    if (!d->threadRunning.load(std::memory_order_acquire)) {
+        d->startThread();
+        if (this == QCommandLineDiagnosticSink::defaultSink()) {
+            static const int registered = atexit([] {
+                static_cast<QCommandLineRingBufferSink *>(QCommandLineDiagnosticSink::defaultSink())->flush();
+            });
+            (void)registered;
+        }
+    }
+    if (!d->pending.exchange(true))
+        d->wake.notify_one();
+}
+
+/*!
+    Writes out all queued warnings on the calling thread.
+*/
+void QCommandLineRingBufferSink::flush()
+{
+    d->drain();
+}
+
+/*!
+    Returns the number of warnings dropped so far by rate limiting or
+    because the buffer was full.
+*/
+size_t QCommandLineRingBufferSink::droppedCount() const
+{
+    return d->droppedTotal.load(std::memory_order_relaxed);
+}
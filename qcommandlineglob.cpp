@@ -0,0 +1,404 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Copyright (C) 2013 David Faure <faure@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcommandlineglob_p.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+bool qCommandLineIsGlobPattern(const std::string &argument)
+{
+    return argument.find_first_of("*?[") != std::string::npos;
+}
+
+// Matches \a c against the bracket expression starting at \a pattern[position].
+// Returns the position after the closing bracket, or npos if there is none,
+// in which case the bracket is an ordinary character.
+static size_t matchBracket(std::string_view pattern, size_t position, unsigned char c, bool *matched)
+{
+    size_t i = position + 1;
+    const bool negated = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+    if (negated)
+        ++i;
+    bool found = false;
+    for (bool first = true; i < pattern.size(); first = false) {
+        if (pattern[i] == ']' && !first) {
+            *matched = found != negated;
+            return i + 1;
+        }
+        const unsigned char low = pattern[i];
+        unsigned char high = low;
+        if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+            high = pattern[i + 2];
+            i += 3;
+        } else {
+            ++i;
+        }
+        if (low <= c && c <= high)
+            found = true;
+    }
+    return std::string_view::npos;
+}
+
+// Matches one path component \a name against one pattern component.
+static bool matchComponent(std::string_view pattern, std::string_view name)
+{
+    if (!name.empty() && name[0] == '.' && (pattern.empty() || pattern[0] != '.'))
+        return false;
+
+    size_t p = 0;
+    size_t n = 0;
+    size_t starPattern = std::string_view::npos;
+    size_t starName = 0;
+    while (n < name.size()) {
+        if (p < pattern.size()) {
+            if (pattern[p] == '*') {
+                starPattern = ++p;
+                starName = n;
+                continue;
+            }
+            if (pattern[p] == '?') {
+                // One character, which is a whole UTF-8 sequence
+                ++p;
+                ++n;
+                while (n < name.size() && (static_cast<unsigned char>(name[n]) & 0xC0) == 0x80)
+                    ++n;
+                continue;
+            }
+            bool matched = false;
+            const size_t end = pattern[p] == '[' ? matchBracket(pattern, p, name[n], &matched)
+                                                 : std::string_view::npos;
+            if (end != std::string_view::npos ? matched : pattern[p] == name[n]) {
+                p = end != std::string_view::npos ? end : p + 1;
+                ++n;
+                continue;
+            }
+        }
+        if (starPattern == std::string_view::npos)
+            return false;
+        p = starPattern;
+        n = ++starName;
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+        ++p;
+    return p == pattern.size();
+}
+
+namespace {
+
+// The matches and subdirectories of one directory, in directory order. An
+// item is either a match or, if it has children, the walk below a directory.
+struct GlobNode
+{
+    enum State { Queued, Visiting, Visited };
+
+    struct Item
+    {
+        std::string path;
+        std::unique_ptr<GlobNode> children;
+    };
+
+    GlobNode() : state(Queued) { }
+
+    //! The item indexes leading from the root to this node, which order the
+    //! nodes as their matches are passed on.
+    std::vector<uint32_t> sequence;
+    std::string prefix;
+    //! The pattern components the entries of the directory may match next.
+    std::vector<uint32_t> states;
+    State state;
+    std::vector<Item> items;
+};
+
+struct GlobNodeOrder
+{
+    bool operator()(const GlobNode *a, const GlobNode *b) const { return a->sequence < b->sequence; }
+};
+
+// Walks the directory tree below the literal prefix of a pattern. The
+// pattern components are matched like a small NFA: each directory is visited
+// with the set of component indexes that its entries may match next.
+//
+// Matches are passed on by the calling thread in order while helper threads
+// visit the directories that come next, the next one first. The calling
+// thread only waits for the directory whose matches are due, and visits it
+// itself if no helper has taken it yet; helpers stop taking directories
+// while MaxBufferedItems items wait to be passed on.
+class GlobWalker
+{
+public:
+    GlobWalker(std::vector<std::string> components, bool directoriesOnly)
+        : components(std::move(components)),
+          directoriesOnly(directoriesOnly),
+          buffered(0),
+          finished(false)
+    { }
+    ~GlobWalker();
+
+    size_t run(const std::string &prefix, const std::function<void(std::string &&path)> &match);
+
+private:
+    enum { MaxBufferedItems = 65536 };
+
+    std::vector<uint32_t> closure(std::vector<uint32_t> states) const;
+    void visit(GlobNode *node) const;
+    void finishVisit(GlobNode *node);
+    void waitForVisit(GlobNode *node);
+    size_t emit(GlobNode *node, const std::function<void(std::string &&path)> &match);
+    void work();
+
+    const std::vector<std::string> components;
+    const bool directoriesOnly;
+
+    //! Outlives the helpers, which may still visit nodes if match throws.
+    GlobNode root;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::set<GlobNode *, GlobNodeOrder> queue;
+    //! Items of visited directories that were not passed on yet.
+    size_t buffered;
+    bool finished;
+    std::vector<std::thread> helpers;
+};
+
+}
+
+GlobWalker::~GlobWalker()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+    }
+    condition.notify_all();
+    for (std::thread &helper : helpers)
+        helper.join();
+}
+
+// Adds the states reachable by letting "**" components match no directory.
+std::vector<uint32_t> GlobWalker::closure(std::vector<uint32_t> states) const
+{
+    for (size_t i = 0; i < states.size(); ++i) {
+        const uint32_t state = states[i];
+        if (state < components.size() && components[state] == "**")
+            states.push_back(state + 1);
+    }
+    std::sort(states.begin(), states.end());
+    states.erase(std::unique(states.begin(), states.end()), states.end());
+    return states;
+}
+
+void GlobWalker::visit(GlobNode *node) const
+{
+    struct Entry
+    {
+        std::string name;
+        bool isDirectory;
+        bool isSymlink;
+    };
+    std::vector<Entry> entries;
+    std::error_code error;
+    std::filesystem::directory_iterator it(node->prefix.empty() ? std::string(".") : node->prefix, error);
+    for (const std::filesystem::directory_iterator end; !error && it != end; it.increment(error)) {
+        std::error_code statusError;
+        entries.push_back({it->path().filename().string(), it->is_directory(statusError),
+                           it->is_symlink(statusError)});
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.name < b.name;
+    });
+
+    const uint32_t last = static_cast<uint32_t>(components.size());
+    for (const Entry &entry : entries) {
+        std::vector<uint32_t> next;
+        bool recursive = false;
+        for (uint32_t state : node->states) {
+            if (state == last)
+                continue;
+            const std::string &component = components[state];
+            if (component == "**") {
+                if (entry.name[0] != '.') {
+                    next.push_back(state);
+                    recursive = true;
+                }
+            } else if (matchComponent(component, entry.name)) {
+                next.push_back(state + 1);
+            }
+        }
+        if (next.empty())
+            continue;
+        next = closure(std::move(next));
+
+        const std::string path = node->prefix + entry.name;
+        if (next.back() == last && (!directoriesOnly || entry.isDirectory))
+            node->items.push_back({directoriesOnly ? path + '/' : path, nullptr});
+        // Symbolic links are not followed by "**", which could loop forever
+        if (entry.isDirectory && next.front() != last && !(entry.isSymlink && recursive)) {
+            if (next.back() == last)
+                next.pop_back();
+            std::unique_ptr<GlobNode> child(new GlobNode);
+            child->sequence = node->sequence;
+            child->sequence.push_back(static_cast<uint32_t>(node->items.size()));
+            child->prefix = path + '/';
+            child->states = std::move(next);
+            node->items.push_back({std::string(), std::move(child)});
+        }
+    }
+}
+
+// Publishes the items of \a node and queues its subdirectories. Called with
+// the mutex locked.
+void GlobWalker::finishVisit(GlobNode *node)
+{
+    node->state = GlobNode::Visited;
+    buffered += node->items.size();
+    for (GlobNode::Item &item : node->items) {
+        if (item.children)
+            queue.insert(item.children.get());
+    }
+    // Helpers are only started once there is more than one directory to walk
+    if (helpers.empty() && queue.size() > 1) {
+        const unsigned threadCount = std::min(std::max(std::thread::hardware_concurrency(), 1u), 16u);
+        for (unsigned i = 1; i < threadCount; ++i)
+            helpers.emplace_back(&GlobWalker::work, this);
+    }
+    condition.notify_all();
+}
+
+void GlobWalker::work()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        condition.wait(lock, [this] { return finished || (!queue.empty() && buffered < MaxBufferedItems); });
+        if (finished)
+            return;
+        GlobNode *node = *queue.begin();
+        queue.erase(queue.begin());
+        node->state = GlobNode::Visiting;
+        lock.unlock();
+
+        visit(node);
+
+        lock.lock();
+        finishVisit(node);
+    }
+}
+
+void GlobWalker::waitForVisit(GlobNode *node)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (node->state == GlobNode::Queued) {
+        // Its matches are due next: rather than wait for a helper, visit it here
+        queue.erase(node);
+        node->state = GlobNode::Visiting;
+        lock.unlock();
+        visit(node);
+        lock.lock();
+        finishVisit(node);
+        return;
+    }
+    condition.wait(lock, [node] { return node->state == GlobNode::Visited; });
+}
+
+// Passes on the matches of \a node and of its subdirectories in order, and
+// releases each subdirectory once it is done.
+size_t GlobWalker::emit(GlobNode *node, const std::function<void(std::string &&path)> &match)
+{
+    waitForVisit(node);
+    size_t count = 0;
+    for (GlobNode::Item &item : node->items) {
+        if (item.children) {
+            count += emit(item.children.get(), match);
+            item.children.reset();
+        } else {
+            match(std::move(item.path));
+            ++count;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffered -= node->items.size();
+    }
+    condition.notify_all();
+    return count;
+}
+
+size_t GlobWalker::run(const std::string &prefix, const std::function<void(std::string &&path)> &match)
+{
+    root.prefix = prefix;
+    root.states = closure(std::vector<uint32_t>(1, 0));
+    return emit(&root, match);
+}
+
+size_t qCommandLineExpandGlob(const std::string &pattern, const std::function<void(std::string &&path)> &match)
+{
+    // Literal leading components are not matched but prepended as written
+    std::string prefix;
+    std::vector<std::string> components;
+    size_t position = 0;
+    if (!pattern.empty() && pattern[0] == '/') {
+        prefix = "/";
+        position = 1;
+    }
+    while (position < pattern.size()) {
+        size_t end = pattern.find('/', position);
+        if (end == std::string::npos)
+            end = pattern.size();
+        std::string component = pattern.substr(position, end - position);
+        position = end + 1;
+        if (component.empty())
+            continue;
+        if (components.empty() && !qCommandLineIsGlobPattern(component) && position < pattern.size())
+            prefix += component + '/';
+        else
+            components.push_back(std::move(component));
+    }
+    if (components.empty())
+        return 0;
+
+    GlobWalker walker(std::move(components), pattern.back() == '/');
+    return walker.run(prefix, match);
+}
@@ -0,0 +1,68 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCOMMANDLINEGLOB_P_H
+#define QCOMMANDLINEGLOB_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the public API. It is used by QCommandLineParser
+// to expand glob patterns in positional arguments and may change without
+// notice.
+//
+
+#include <functional>
+#include <string>
+
+// Returns true if \a argument contains any of the glob characters *, ? or [.
+bool qCommandLineIsGlobPattern(const std::string &argument);
+
+// Expands the glob \a pattern against the file system and passes each match
+// to \a match, in directory order: names sorted bytewise within a directory,
+// a directory before its contents. Returns the number of matches.
+//
+// "*", "?" and "[...]" match within one path component and never match a
+// leading dot; a "**" component matches any number of directories. The
+// directory tree is walked by several threads, but \a match is only called
+// from the calling thread. Matches are passed on as soon as the directories
+// before them in order are walked, so only a bounded number of them is held
+// back, however large the tree.
+size_t qCommandLineExpandGlob(const std::string &pattern, const std::function<void(std::string &&path)> &match);
+
+#endif // QCOMMANDLINEGLOB_P_H
@@ -0,0 +1,309 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Copyright (C) 2013 David Faure <faure@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcommandlineimage.h"
+#include "qcommandlineimage_p.h"
+#include "qcommandlinediagnostics_p.h"
+
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace QCommandLineImageFormat;
+
+class QCommandLineImagePrivate
+{
+public:
+    QCommandLineImagePrivate(const void *data, size_t size)
+        : data(static_cast<const char *>(data)),
+          size(size),
+          mapping(nullptr),
+          valid(false)
+    {
+        valid = validate();
+    }
+
+    ~QCommandLineImagePrivate()
+    {
+#if !defined(_WIN32)
+        if (mapping)
+            munmap(mapping, size);
+#endif
+    }
+
+    template <typename T>
+    T read(size_t position) const
+    {
+        T result;
+        memcpy(&result, data + position, sizeof(T));
+        return result;
+    }
+
+    bool validate();
+    bool fits(uint64_t offset, uint64_t count, uint64_t elementSize) const;
+    bool valuesFit(const Option &entry) const;
+    std::string_view string(const String &ref) const;
+    std::string_view string(size_t index) const;
+    size_t findOption(const std::string &name) const;
+
+    const char *data;
+    size_t size;
+    //! Set when the image owns a mapping of data.
+    void *mapping;
+    Header header;
+    bool valid;
+};
+
+bool QCommandLineImagePrivate::fits(uint64_t offset, uint64_t count, uint64_t elementSize) const
+{
+    return offset <= header.size && count <= (header.size - offset) / elementSize;
+}
+
+bool QCommandLineImagePrivate::validate()
+{
+    if (!data || size < sizeof(Header))
+        return false;
+    header = read<Header>(0);
+    return memcmp(header.magic, Magic, sizeof(Magic)) == 0
+            && header.version == Version
+            && header.size <= size
+            && fits(header.namesOffset, header.nameCount, sizeof(Name))
+            && fits(header.optionsOffset, header.optionCount, sizeof(Option))
+            && fits(header.stringsOffset, header.stringCount, sizeof(String))
+            && fits(header.bytesOffset, header.bytesSize, 1)
+            && header.firstPositional <= header.stringCount
+            && header.positionalCount <= header.stringCount - header.firstPositional;
+}
+
+// Option entries are only checked on use, so that opening an image stays
+// independent of its size; the counts come from the buffer and cannot be
+// trusted before they are checked against the string table.
+bool QCommandLineImagePrivate::valuesFit(const Option &entry) const
+{
+    return entry.firstValue <= header.stringCount && entry.valueCount <= header.stringCount - entry.firstValue;
+}
+
+std::string_view QCommandLineImagePrivate::string(const String &ref) const
+{
+    if (ref.offset > header.bytesSize || ref.length > header.bytesSize - ref.offset)
+        return std::string_view();
+    return std::string_view(data + header.bytesOffset + ref.offset, ref.length);
+}
+
+std::string_view QCommandLineImagePrivate::string(size_t index) const
+{
+    if (index >= header.stringCount)
+        return std::string_view();
+    return string(read<String>(header.stringsOffset + index * sizeof(String)));
+}
+
+size_t QCommandLineImagePrivate::findOption(const std::string &name) const
+{
+    size_t low = 0;
+    size_t high = header.nameCount;
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        const Name entry = read<Name>(header.namesOffset + middle * sizeof(Name));
+        const int comparison = string(entry.name).compare(name);
+        if (comparison == 0)
+            return entry.option < header.optionCount ? entry.option : std::string::npos;
+        if (comparison < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return std::string::npos;
+}
+
+/*!
+    Constructs an invalid image.
+*/
+QCommandLineImage::QCommandLineImage()
+    : d(std::make_shared<QCommandLineImagePrivate>(nullptr, 0))
+{
+}
+
+/*!
+    Opens the image written by QCommandLineSnapshot::toImage() at \a data in
+    place. Nothing is copied or parsed: only the header is checked, and
+    lookups read the buffer directly. The buffer must stay valid and
+    unchanged as long as the image or any view returned by it is in use.
+*/
+QCommandLineImage::QCommandLineImage(const void *data, size_t size)
+    : d(std::make_shared<QCommandLineImagePrivate>(data, size))
+{
+}
+
+QCommandLineImage::QCommandLineImage(const QCommandLineImage &other)
+    : d(other.d)
+{
+}
+
+QCommandLineImage::~QCommandLineImage()
+{
+}
+
+QCommandLineImage &QCommandLineImage::operator=(const QCommandLineImage &other)
+{
+    d = other.d;
+    return *this;
+}
+
+/*!
+    Maps the image stored in the file or shared memory object \a fd read-only
+    and opens it in place. The mapping is released with the last copy of the
+    returned image; \a fd can be closed right away.
+*/
+QCommandLineImage QCommandLineImage::map(int fd)
+{
+    QCommandLineImage image;
+#if !defined(_WIN32)
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size <= 0) {
+        qCommandLineWarning({"QCommandLineImage: cannot stat image file descriptor"});
+        return image;
+    }
+    const size_t size = status.st_size;
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        qCommandLineWarning({"QCommandLineImage: cannot map image file descriptor"});
+        return image;
+    }
+    image.d = std::make_shared<QCommandLineImagePrivate>(mapping, size);
+    image.d->mapping = mapping;
+#else
+    (void)fd;
+    qCommandLineWarning({"QCommandLineImage: mapping images is not supported on this platform"});
+#endif
+    return image;
+}
+
+#if defined(__linux__)
+/*!
+    Copies \a image into a new sealed memfd and returns its descriptor, or -1
+    on failure. The descriptor is not close-on-exec, so workers that are
+    forked or spawned can pass it to map().
+*/
+int QCommandLineImage::createMemfd(const std::string &image)
+{
+    const int fd = memfd_create("qcommandlineimage", MFD_ALLOW_SEALING);
+    if (fd < 0)
+        return -1;
+    size_t written = 0;
+    while (written < image.size()) {
+        const ssize_t result = write(fd, image.data() + written, image.size() - written);
+        if (result < 0) {
+            close(fd);
+            return -1;
+        }
+        written += result;
+    }
+    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+    return fd;
+}
+#endif
+
+bool QCommandLineImage::isValid() const
+{
+    return d->valid;
+}
+
+const void *QCommandLineImage::data() const
+{
+    return d->data;
+}
+
+size_t QCommandLineImage::size() const
+{
+    return d->valid ? d->header.size : 0;
+}
+
+bool QCommandLineImage::isSet(const std::string &name) const
+{
+    if (!d->valid)
+        return false;
+    const size_t option = d->findOption(name);
+    return option != std::string::npos
+            && d->read<Option>(d->header.optionsOffset + option * sizeof(Option)).isSet;
+}
+
+std::string_view QCommandLineImage::value(const std::string &name) const
+{
+    if (!d->valid)
+        return std::string_view();
+    const size_t option = d->findOption(name);
+    if (option == std::string::npos)
+        return std::string_view();
+    const Option entry = d->read<Option>(d->header.optionsOffset + option * sizeof(Option));
+    if (entry.valueCount == 0 || !d->valuesFit(entry))
+        return std::string_view();
+    return d->string(size_t(entry.firstValue) + entry.valueCount - 1);
+}
+
+std::vector<std::string_view> QCommandLineImage::values(const std::string &name) const
+{
+    std::vector<std::string_view> result;
+    if (!d->valid)
+        return result;
+    const size_t option = d->findOption(name);
+    if (option == std::string::npos)
+        return result;
+    const Option entry = d->read<Option>(d->header.optionsOffset + option * sizeof(Option));
+    if (!d->valuesFit(entry))
+        return result;
+    result.reserve(entry.valueCount);
+    for (uint32_t i = 0; i < entry.valueCount; ++i)
+        result.push_back(d->string(size_t(entry.firstValue) + i));
+    return result;
+}
+
+std::vector<std::string_view> QCommandLineImage::positionalArguments() const
+{
+    std::vector<std::string_view> result;
+    if (!d->valid)
+        return result;
+    result.reserve(d->header.positionalCount);
+    for (uint32_t i = 0; i < d->header.positionalCount; ++i)
+        result.push_back(d->string(size_t(d->header.firstPositional) + i));
+    return result;
+}
@@ -0,0 +1,77 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCOMMANDLINEIMAGE_H
+#define QCOMMANDLINEIMAGE_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class QCommandLineImagePrivate;
+
+class QCommandLineImage
+{
+public:
+    QCommandLineImage();
+    QCommandLineImage(const void *data, size_t size);
+    QCommandLineImage(const QCommandLineImage &other);
+    ~QCommandLineImage();
+
+    QCommandLineImage &operator=(const QCommandLineImage &other);
+
+    static QCommandLineImage map(int fd);
+#if defined(__linux__)
+    static int createMemfd(const std::string &image);
+#endif
+
+    bool isValid() const;
+    const void *data() const;
+    size_t size() const;
+
+    bool isSet(const std::string &name) const;
+    std::string_view value(const std::string &name) const;
+    std::vector<std::string_view> values(const std::string &name) const;
+
+    std::vector<std::string_view> positionalArguments() const;
+
+private:
+    std::shared_ptr<QCommandLineImagePrivate> d;
+};
+
+#endif // QCOMMANDLINEIMAGE_H
@@ -0,0 +1,100 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCOMMANDLINEIMAGE_P_H
+#define QCOMMANDLINEIMAGE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the public API. It describes the binary layout
+// written by QCommandLineSnapshot::toImage() and read by QCommandLineImage.
+//
+
+#include <cstdint>
+
+// All offsets are relative to the start of the image, so it can be mapped
+// anywhere. Integers are stored in host byte order: an image is meant to be
+// shared between processes on one machine, not to be stored.
+namespace QCommandLineImageFormat {
+
+static const char Magic[8] = { 'Q', 'C', 'L', 'I', 'M', 'G', '\0', '\0' };
+static const uint32_t Version = 1;
+
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t size;
+    //! Option names sorted bytewise, for binary search.
+    uint32_t nameCount;
+    uint32_t namesOffset;
+    uint32_t optionCount;
+    uint32_t optionsOffset;
+    //! Option values followed by the positional arguments.
+    uint32_t stringCount;
+    uint32_t stringsOffset;
+    uint32_t positionalCount;
+    uint32_t firstPositional;
+    uint32_t bytesOffset;
+    uint32_t bytesSize;
+};
+
+struct String
+{
+    //! Relative to Header::bytesOffset.
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct Name
+{
+    String name;
+    uint32_t option;
+};
+
+struct Option
+{
+    uint32_t firstValue;
+    uint32_t valueCount;
+    uint32_t isSet;
+};
+
+} // namespace QCommandLineImageFormat
+
+#endif // QCOMMANDLINEIMAGE_P_H
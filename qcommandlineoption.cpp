@@ -39,16 +39,37 @@
 ****************************************************************************/
 
 #include "qcommandlineoption.h"
+#include "qcommandlinediagnostics_p.h"
+#include "qcommandlineoptiontable_p.h"
 
 #include <algorithm>
-#include <iostream>
+#include <atomic>
 #include <set>
 
+static std::atomic<size_t> constraintGeneration(0);
+
+size_t qCommandLineConstraintGeneration()
+{
+    return constraintGeneration.load(std::memory_order_acquire);
+}
+
+// Makes parsers compile the constraints again before their next parse.
+static void constraintsChanged()
+{
+    constraintGeneration.fetch_add(1, std::memory_order_release);
+}
+
 class QCommandLineOptionPrivate
 {
 public:
     explicit QCommandLineOptionPrivate(const std::string &name)
-        : hidden(false)
+        : hidden(false),
+          required(false),
+          hasValueRange(false),
+          minimumValue(0),
+          maximumValue(0),
+          valueFromFileAllowed(false),
+          occurrencePolicy(QCommandLineOption::AppendOccurrences)
     {
         names.push_back(name);
         names = removeInvalidNames(names);
@@ -56,7 +77,13 @@ public:
 
     explicit QCommandLineOptionPrivate(const std::vector<std::string> &names)
         : names(removeInvalidNames(names)),
-          hidden(false)
+          hidden(false),
+          required(false),
+          hasValueRange(false),
+          minimumValue(0),
+          maximumValue(0),
+          valueFromFileAllowed(false),
+          occurrencePolicy(QCommandLineOption::AppendOccurrences)
     { }
 
     static std::vector<std::string> removeInvalidNames(std::vector<std::string> nameList);
@@ -71,11 +98,37 @@ public:
     //! The description used for this option.
     std::string description;
 
+    //! Computes the description when it is needed, replacing description if set.
+    std::function<std::string()> descriptionProvider;
+
+    //! The help section this option is listed in; empty for the main one.
+    std::string group;
+
     //! The list of default values used for this option.
     std::vector<std::string> defaultValues;
 
     //! Show or hide in --help
     bool hidden;
+
+    //! Whether parsing fails when the option is not given
+    bool required;
+
+    //! Names of the options that must be given along with this one
+    std::vector<std::string> dependencies;
+
+    //! Inclusive integer range every value must fall into, if set
+    bool hasValueRange;
+    long long minimumValue;
+    long long maximumValue;
+
+    //! The values accepted for this option; empty accepts anything
+    std::vector<std::string> allowedValues;
+
+    //! Whether a value of the form "@path" stands for the contents of path
+    bool valueFromFileAllowed;
+
+    //! How repeated occurrences of the option are recorded by the parser
+    QCommandLineOption::OccurrencePolicy occurrencePolicy;
 };
 
 QCommandLineOption::QCommandLineOption(const std::string &name)
@@ -152,7 +205,7 @@ namespace {
 
         static bool warn(const char *what)
         {
-            std::cerr << "QCommandLineOption: Option names cannot " << what << std::endl;
+            qCommandLineWarning({"QCommandLineOption: Option names cannot ", what});
             return true;
         }
     };
@@ -162,7 +215,7 @@ namespace {
 std::vector<std::string> QCommandLineOptionPrivate::removeInvalidNames(std::vector<std::string> nameList)
 {
     if (nameList.empty())
-        std::cerr << "QCommandLineOption: Options must have at least one name" << std::endl;
+        qCommandLineWarning({"QCommandLineOption: Options must have at least one name"});
     else
         nameList.erase(std::remove_if(nameList.begin(), nameList.end(), IsInvalidName()),
                        nameList.end());
@@ -182,13 +235,43 @@ std::string QCommandLineOption::valueName() const
 void QCommandLineOption::setDescription(const std::string &description)
 {
     d->description = description;
+    d->descriptionProvider = nullptr;
+}
+
+/*!
+    Sets \a provider to compute the description each time it is needed,
+    typically only when QCommandLineParser::helpText() is rendered. Use this
+    for descriptions that are expensive to build, such as lists of available
+    plugins. Calling setDescription() removes the provider.
+*/
+void QCommandLineOption::setDescriptionProvider(const std::function<std::string()> &provider)
+{
+    d->descriptionProvider = provider;
 }
 
 std::string QCommandLineOption::description() const
 {
+    if (d->descriptionProvider)
+        return d->descriptionProvider();
     return d->description;
 }
 
+/*!
+    Lists this option under the heading \a group in the help text instead of
+    under "Options". Options of a group are listed in the order they were added.
+
+    \sa QCommandLineParser::helpText()
+*/
+void QCommandLineOption::setGroup(const std::string &group)
+{
+    d->group = group;
+}
+
+std::string QCommandLineOption::group() const
+{
+    return d->group;
+}
+
 void QCommandLineOption::setDefaultValue(const std::string &defaultValue)
 {
     std::vector<std::string> newDefaultValues;
@@ -220,3 +303,141 @@ bool QCommandLineOption::isHidden() const
     return d->hidden;
 }
 
+/*!
+    Sets whether the option must be given on the command line to \a required.
+
+    A missing required option makes QCommandLineParser::parse() fail with a
+    QCommandLineParser::MissingRequiredOption error.
+*/
+void QCommandLineOption::setRequired(bool required)
+{
+    d->required = required;
+    constraintsChanged();
+}
+
+bool QCommandLineOption::isRequired() const
+{
+    return d->required;
+}
+
+/*!
+    Sets the names of the options that must also be given whenever this
+    option is given to \a optionNames.
+*/
+void QCommandLineOption::setDependencies(const std::vector<std::string> &optionNames)
+{
+    d->dependencies = optionNames;
+    constraintsChanged();
+}
+
+std::vector<std::string> QCommandLineOption::dependencies() const
+{
+    return d->dependencies;
+}
+
+/*!
+    Requires every value of this option to be an integer between \a minimum
+    and \a maximum inclusive. A range with \a minimum greater than
+    \a maximum is rejected with a warning and leaves the option unchanged.
+*/
+void QCommandLineOption::setValueRange(long long minimum, long long maximum)
+{
+    if (minimum > maximum) {
+        qCommandLineWarning({"QCommandLineOption: invalid value range ", std::to_string(minimum), "..",
+                             std::to_string(maximum), " for option \"", d->names.empty() ? std::string() : d->names.front(), "\""});
+        return;
+    }
+    d->hasValueRange = true;
+    d->minimumValue = minimum;
+    d->maximumValue = maximum;
+    constraintsChanged();
+}
+
+bool QCommandLineOption::hasValueRange() const
+{
+    return d->hasValueRange;
+}
+
+long long QCommandLineOption::minimumValue() const
+{
+    return d->minimumValue;
+}
+
+long long QCommandLineOption::maximumValue() const
+{
+    return d->maximumValue;
+}
+
+/*!
+    Restricts the values of this option to \a values. An empty list, the
+    default, accepts any value.
+*/
+void QCommandLineOption::setAllowedValues(const std::vector<std::string> &values)
+{
+    d->allowedValues = values;
+    constraintsChanged();
+}
+
+std::vector<std::string> QCommandLineOption::allowedValues() const
+{
+    return d->allowedValues;
+}
+
+/*!
+    Sets whether a value written as \c{@path} stands for the contents of
+    the file at \c path to \a allowed. This suits large payloads such as
+    certificates or policies that are awkward to pass inline.
+
+    The file is opened when the value is first read, see
+    QCommandLineParser::setValueFileMode() for checking it while parsing.
+    Regular files are mapped into memory, so their contents are only paged
+    in when used and QCommandLineParser::valueView() hands them out without
+    copying; pipes and other files without a size, such as \c{<(command)}
+    process substitutions, are read up to 16 MiB. Write \c{@@} to pass a
+    value that starts with a literal \c{@}.
+
+    \sa isValueFromFileAllowed(), QCommandLineParser::valueView()
+*/
+void QCommandLineOption::setValueFromFileAllowed(bool allowed)
+{
+    d->valueFromFileAllowed = allowed;
+}
+
+/*!
+    Returns true if \c{@path} values of this option are read from files.
+
+    \sa setValueFromFileAllowed()
+*/
+bool QCommandLineOption::isValueFromFileAllowed() const
+{
+    return d->valueFromFileAllowed;
+}
+
+/*!
+    Sets how the parser records repeated occurrences of this option to
+    \a policy:
+
+    \list
+    \li AppendOccurrences, the default, keeps every value and lists the
+        option in QCommandLineParser::optionNames() once per occurrence.
+    \li CountOccurrences only counts the occurrences, as wanted for
+        flags like \c{-vvv}; a value given with the option is kept as with
+        KeepLastOccurrence.
+    \li KeepLastOccurrence keeps the value of the last occurrence only.
+    \li KeepFirstOccurrence keeps the value of the first occurrence only.
+    \li RejectRepeatedOccurrences makes a repeated option a parse error.
+    \endlist
+
+    With any policy but AppendOccurrences the option takes the same memory
+    however often it is repeated. QCommandLineParser::occurrenceCount()
+    returns the number of occurrences in every case.
+*/
+void QCommandLineOption::setOccurrencePolicy(QCommandLineOption::OccurrencePolicy policy)
+{
+    d->occurrencePolicy = policy;
+}
+
+QCommandLineOption::OccurrencePolicy QCommandLineOption::occurrencePolicy() const
+{
+    return d->occurrencePolicy;
+}
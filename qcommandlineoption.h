@@ -40,6 +40,7 @@
 #ifndef QCOMMANDLINEOPTION_H
 #define QCOMMANDLINEOPTION_H
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -75,8 +76,12 @@ public:
     std::string valueName() const;
 
     void setDescription(const std::string &description);
+    void setDescriptionProvider(const std::function<std::string()> &provider);
     std::string description() const;
 
+    void setGroup(const std::string &group);
+    std::string group() const;
+
     void setDefaultValue(const std::string &defaultValue);
     void setDefaultValues(const std::vector<std::string> &defaultValues);
     std::vector<std::string> defaultValues() const;
@@ -84,6 +89,33 @@ public:
     void setHidden(bool hidden);
     bool isHidden() const;
 
+    void setRequired(bool required);
+    bool isRequired() const;
+
+    void setDependencies(const std::vector<std::string> &optionNames);
+    std::vector<std::string> dependencies() const;
+
+    void setValueRange(long long minimum, long long maximum);
+    bool hasValueRange() const;
+    long long minimumValue() const;
+    long long maximumValue() const;
+
+    void setAllowedValues(const std::vector<std::string> &values);
+    std::vector<std::string> allowedValues() const;
+
+    void setValueFromFileAllowed(bool allowed);
+    bool isValueFromFileAllowed() const;
+
+    enum OccurrencePolicy {
+        AppendOccurrences,
+        CountOccurrences,
+        KeepLastOccurrence,
+        KeepFirstOccurrence,
+        RejectRepeatedOccurrences
+    };
+    void setOccurrencePolicy(OccurrencePolicy policy);
+    OccurrencePolicy occurrencePolicy() const;
+
 private:
     std::shared_ptr<QCommandLineOptionPrivate> d;
 };
@@ -0,0 +1,214 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCOMMANDLINEOPTIONTABLE_P_H
+#define QCOMMANDLINEOPTIONTABLE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the public API. It is shared between
+// QCommandLineParser, QCommandLineSnapshot and QCommandLineTable and may
+// change without notice.
+//
+
+#include "qcommandlineoption.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+typedef std::unordered_map<std::string, size_t> NameHash_t;
+
+// Counts the changes to the constraints of any option, such as
+// QCommandLineOption::setRequired(). Options are shared with the code that
+// created them, so compiled constraints are only valid for the generation
+// they were compiled in. Defined in qcommandlineoption.cpp.
+size_t qCommandLineConstraintGeneration();
+
+struct OptionTableLongNames;
+struct OptionTableSuggestions;
+struct OptionTableConstraints;
+
+// The default values of the options of one layer, which snapshots view
+// instead of copying them for every option that was not given.
+struct OptionTableDefaults
+{
+    std::vector<std::vector<std::string>> values;
+    std::vector<std::vector<std::string_view>> views;
+    //! Offsets of the options whose defaults name value files, which
+    //! snapshots resolve themselves.
+    std::vector<size_t> fileDefaults;
+};
+
+// Returns the lookup structure of a layer cached in \a cache, building it
+// with \a build on first use. A layer shared by parsers on several threads
+// may be built twice concurrently, which only costs time: both results are
+// equal.
+template <typename T, typename Build>
+static std::shared_ptr<const T> layerCache(std::shared_ptr<const T> *cache, Build build)
+{
+    std::shared_ptr<const T> result = std::atomic_load(cache);
+    if (!result) {
+        result = build();
+        std::atomic_store(cache, result);
+    }
+    return result;
+}
+
+// One layer of registered options. A layer that is shared with an overlay
+// parser, a snapshot or a table is never modified again: options added later
+// go into a new layer on top of it, so a variant of a large option table only
+// stores its own additions.
+class OptionTable
+{
+public:
+    explicit OptionTable(const std::shared_ptr<const OptionTable> &base = std::shared_ptr<const OptionTable>())
+        : base(base),
+          baseCount(base ? base->size() : 0)
+    { }
+
+    // Merges \a upper into a copy of the layer \a lower below it.
+    OptionTable(const OptionTable &lower, const OptionTable &upper)
+        : base(lower.base),
+          baseCount(lower.baseCount),
+          options(lower.options),
+          nameHash(lower.nameHash),
+          exclusiveNames(lower.exclusiveNames)
+    {
+        options.insert(options.end(), upper.options.cbegin(), upper.options.cend());
+        nameHash.insert(upper.nameHash.cbegin(), upper.nameHash.cend());
+        exclusiveNames.insert(exclusiveNames.end(), upper.exclusiveNames.cbegin(), upper.exclusiveNames.cend());
+    }
+
+    size_t size() const { return baseCount + options.size(); }
+
+    bool isEmpty() const { return options.empty() && exclusiveNames.empty(); }
+
+    size_t find(const std::string &name) const
+    {
+        for (const OptionTable *table = this; table; table = table->base.get()) {
+            const NameHash_t::const_iterator it = table->nameHash.find(name);
+            if (it != table->nameHash.cend())
+                return it->second;
+        }
+        return std::string::npos;
+    }
+
+    const OptionTable *layerOf(size_t offset) const
+    {
+        const OptionTable *table = this;
+        while (offset < table->baseCount)
+            table = table->base.get();
+        return table;
+    }
+
+    const QCommandLineOption &at(size_t offset) const
+    {
+        const OptionTable *table = layerOf(offset);
+        return table->options.at(offset - table->baseCount);
+    }
+
+    std::shared_ptr<const OptionTableDefaults> layerDefaults() const
+    {
+        return layerCache(&defaults, [this]() {
+            std::shared_ptr<OptionTableDefaults> result = std::make_shared<OptionTableDefaults>();
+            result->values.reserve(options.size());
+            for (size_t i = 0; i < options.size(); ++i) {
+                result->values.push_back(options.at(i).defaultValues());
+                if (!options.at(i).isValueFromFileAllowed())
+                    continue;
+                for (const std::string &value : result->values.back()) {
+                    if (!value.empty() && value[0] == '@') {
+                        result->fileDefaults.push_back(baseCount + i);
+                        break;
+                    }
+                }
+            }
+            result->views.reserve(result->values.size());
+            for (const std::vector<std::string> &values : result->values)
+                result->views.emplace_back(values.cbegin(), values.cend());
+            return result;
+        });
+    }
+
+    // Returns views of the default values of the option at \a offset. They
+    // stay valid as long as the layer defining the option.
+    const std::vector<std::string_view> &defaultValues(size_t offset) const
+    {
+        const OptionTable *table = layerOf(offset);
+        return table->layerDefaults()->views.at(offset - table->baseCount);
+    }
+
+    template <typename Function>
+    void forEachName(Function function) const
+    {
+        if (base)
+            base->forEachName(function);
+        for (const NameHash_t::value_type &entry : nameHash)
+            function(entry);
+    }
+
+    void add(const QCommandLineOption &option, const std::vector<std::string> &names)
+    {
+        const size_t offset = size();
+        options.push_back(option);
+        for (const std::string &name : names)
+            nameHash.insert({name, offset});
+    }
+
+    const std::shared_ptr<const OptionTable> base;
+    const size_t baseCount;
+    std::vector<QCommandLineOption> options;
+    NameHash_t nameHash;
+
+    //! Names given to addMutuallyExclusiveOptions() while this layer was on top.
+    std::vector<std::vector<std::string>> exclusiveNames;
+
+    //! Lookup structures over the options of this layer alone, built on first
+    //! use and then shared read-only by every parser stacked on the layer.
+    //! Accessed with std::atomic_load() and std::atomic_store() only.
+    mutable std::shared_ptr<const OptionTableLongNames> longNames;
+    mutable std::shared_ptr<const OptionTableSuggestions> suggestions;
+    mutable std::shared_ptr<const OptionTableConstraints> constraints;
+    mutable std::shared_ptr<const OptionTableDefaults> defaults;
+};
+
+#endif // QCOMMANDLINEOPTIONTABLE_P_H
@@ -39,51 +39,292 @@
 ****************************************************************************/
 
 #include "qcommandlineparser.h"
+#include "qcommandlinesnapshot_p.h"
+#include "qcommandlinediagnostics_p.h"
+#include "qcommandlineglob_p.h"
+#include "qcommandlineoptiontable_p.h"
+#include "qcommandlinestringpool.h"
+#include "qcommandlinetable_p.h"
 
 #include <algorithm>
 #include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
 #include <codecvt>
-#include <iostream>
-#include <iomanip>
-#include <sstream>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unordered_map>
+#include <unordered_set>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #if defined(_WIN32)
 #include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 //QT_BEGIN_NAMESPACE
 
-typedef std::unordered_map<std::string, size_t> NameHash_t;
+typedef std::vector<std::pair<std::string, size_t>> LongNameIndex_t;
+
+// Long option names of one layer sorted by name, for prefix matching.
+struct OptionTableLongNames
+{
+    LongNameIndex_t names;
+};
+
+// The option names of one layer bucketed by length plus a trigram index over
+// them, for "did you mean" suggestions.
+struct OptionTableSuggestions
+{
+    std::vector<std::pair<std::string, size_t>> names;
+    std::vector<std::vector<uint32_t>> namesByLength;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> namesByTrigram;
+};
+
+// The constraints of the options of one layer, compiled into offsets. Names
+// that neither the layer nor the layers below it define are kept as names,
+// as an overlay may still add those options.
+struct OptionTableConstraints
+{
+    OptionTableConstraints() : generation(0) { }
+
+    struct ValueRange
+    {
+        size_t optionOffset;
+        long long minimum;
+        long long maximum;
+    };
+
+    std::vector<size_t> required;
+    std::vector<std::vector<size_t>> exclusiveGroups;
+    std::vector<std::pair<size_t, size_t>> dependencies;
+    std::vector<ValueRange> valueRanges;
+    std::vector<std::pair<size_t, std::vector<std::string>>> allowedValues;
+    std::vector<std::pair<size_t, std::string>> unresolvedDependencies;
+    std::vector<std::vector<std::string>> unresolvedGroups;
+    //! The qCommandLineConstraintGeneration() compiled in.
+    size_t generation;
+};
+
+// Pipes, devices and files without a size are read into memory, up to this
+// many bytes, so that "@/dev/zero" fails instead of exhausting memory.
+static const size_t MaximumReadValueFileSize = 16 * 1024 * 1024;
+
+// The read-only contents of a file named by an "@path" option value. Regular
+// files are mapped where mmap is available so that large payloads are never
+// copied; pipes, devices and files that report no size, such as those in
+// /proc, are read instead.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path)
+        : mapping(nullptr),
+          size(0),
+          errorCode(0)
+    {
+#if !defined(_WIN32)
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            errorCode = errno;
+            return;
+        }
+        struct stat status;
+        if (fstat(fd, &status) != 0) {
+            errorCode = errno;
+        } else if (S_ISREG(status.st_mode) && status.st_size > 0) {
+            void *address = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address == MAP_FAILED) {
+                errorCode = errno;
+            } else {
+                mapping = address;
+                size = status.st_size;
+            }
+        } else {
+            char buffer[65536];
+            ssize_t count;
+            while ((count = ::read(fd, buffer, sizeof(buffer))) != 0) {
+                if (count < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    errorCode = errno;
+                    break;
+                }
+                if (contents.size() + size_t(count) > MaximumReadValueFileSize) {
+                    errorCode = EFBIG;
+                    break;
+                }
+                contents.append(buffer, size_t(count));
+            }
+        }
+        ::close(fd);
+#else
+        FILE *file = fopen(path.c_str(), "rb");
+        if (!file) {
+            errorCode = errno;
+            return;
+        }
+        char buffer[65536];
+        size_t count;
+        while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            if (contents.size() + count > MaximumReadValueFileSize) {
+                errorCode = EFBIG;
+                break;
+            }
+            contents.append(buffer, count);
+        }
+        if (!errorCode && ferror(file))
+            errorCode = EIO;
+        fclose(file);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#if !defined(_WIN32)
+        if (mapping)
+            munmap(mapping, size);
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    //! The errno value of the failed open, stat, map or read, or EFBIG if a
+    //! file that must be read is too large, or 0.
+    int error() const { return errorCode; }
+
+    std::string_view view() const
+    {
+        if (errorCode)
+            return std::string_view();
+        return mapping ? std::string_view(static_cast<const char *>(mapping), size) : std::string_view(contents);
+    }
+
+private:
+    void *mapping;
+    size_t size;
+    std::string contents;
+    int errorCode;
+};
 
 class QCommandLineParserPrivate
 {
 public:
     inline QCommandLineParserPrivate()
-        : singleDashWordOptionMode(QCommandLineParser::ParseAsCompactedShortOptions),
+        : optionTable(std::make_shared<OptionTable>()),
+          singleDashWordOptionMode(QCommandLineParser::ParseAsCompactedShortOptions),
           optionsAfterPositionalArgumentsMode(QCommandLineParser::ParseAsOptions),
+          longOptionMatchingMode(QCommandLineParser::MatchExactLongOptions),
+          positionalArgumentExpansionMode(QCommandLineParser::KeepPositionalArguments),
+          valueFileMode(QCommandLineParser::ReadValueFilesOnFirstUse),
           builtinVersionOption(false),
           builtinHelpOption(false),
           needsParsing(true)
     { }
 
+    size_t findOption(const std::string &name) const { return optionTable->find(name); }
+    const QCommandLineOption &option(size_t offset) const { return optionTable->at(offset); }
+    bool readsValueFiles(size_t offset) const
+    {
+        return valueFileMode != QCommandLineParser::IgnoreValueFiles && option(offset).isValueFromFileAllowed();
+    }
+    size_t optionCount() const { return optionTable->size(); }
+    std::shared_ptr<const OptionTable> shareOptionTable() const;
+    OptionTable *writableOptionTable();
+    void optionTableChanged();
+
     bool parse(const std::vector<std::string> &args);
+    bool reparse(const std::vector<std::string> &args);
     void checkParsed(const char *method);
-    std::vector<std::string> aliases(const std::string &name) const;
     std::string helpText() const;
-    bool registerFoundOption(const std::string &optionName);
+    std::string groupHelpText(const std::string &group) const;
+    std::vector<std::pair<std::string, std::vector<size_t>>> helpSections() const;
+    std::vector<std::string> helpOptionNames(const std::vector<std::pair<std::string, std::vector<size_t>>> &sections,
+                                             size_t *nameColumnWidth) const;
+    bool registerFoundOption(const std::string &optionName, size_t argumentIndex, size_t byteOffset);
+    bool expandLongOptionName(std::string *optionName);
+    std::vector<std::string> longOptionCandidates(const std::string &prefix);
+    std::vector<std::string> suggestions(const std::string &unknownName);
     bool parseOptionValue(const std::string &optionName, const std::string &argument,
                           std::vector<std::string>::const_iterator *argumentIterator,
-                          std::vector<std::string>::const_iterator argsEnd);
+                          std::vector<std::string>::const_iterator argsEnd, size_t argumentIndex);
+    void skipOptionValue(const std::string &optionName, const std::string &argument,
+                         std::vector<std::string>::const_iterator *argumentIterator,
+                         std::vector<std::string>::const_iterator argsEnd);
+    void skipAmbiguousOptionValue(const std::string &prefix, const std::string &argument,
+                                  std::vector<std::string>::const_iterator *argumentIterator,
+                                  std::vector<std::string>::const_iterator argsEnd);
+    void addValue(size_t optionOffset, std::string value);
+    bool loadValueFile(size_t optionOffset, const std::string &value, size_t argumentIndex, size_t byteOffset);
+    void addError(QCommandLineParser::ParseErrorKind kind, size_t argumentIndex,
+                  size_t byteOffset, size_t length, size_t optionOffset = std::string::npos,
+                  size_t detail = std::string::npos);
+    void compileConstraints();
+    bool checkConstraints();
+    void expandPositionalArguments();
+    std::string optionDisplayName(size_t optionOffset) const;
+    std::string errorText(const QCommandLineParser::ParseError &error);
+    const std::vector<std::string> *valueList(size_t optionOffset);
+    std::string_view resolveValue(size_t optionOffset, const std::string &value,
+                                  std::shared_ptr<const void> *mappedFile = nullptr);
+
+    //! Errors found by the last parse, in the order they were found.
+    std::vector<QCommandLineParser::ParseError> errors;
+
+    //! The arguments the errors of the last parse point into, by index, kept
+    //! to format errors on demand.
+    std::unordered_map<size_t, std::string> failedArguments;
+
+    //! The top layer of registered options, only modified while no overlay,
+    //! snapshot or table shares it.
+    std::shared_ptr<OptionTable> optionTable;
 
-    std::string errorText;
+    std::unordered_map<size_t, std::vector<std::string>> optionValuesHash;
 
-    std::vector<QCommandLineOption> commandLineOptionList;
-    NameHash_t nameHash;
+    //! Default values by option offset, cached so that views into them stay valid.
+    std::unordered_map<size_t, std::vector<std::string>> defaultValuesHash;
 
-    std::unordered_map<size_t, std::vector<std::string>> optionValuesHash;
+    //! Files named by "@path" values, opened on first read or by parse() as
+    //! the value file mode says, and kept until the next parse.
+    std::unordered_map<std::string, std::shared_ptr<const MappedFile>> mappedFiles;
+
+    //! One bit per option offset, set when the option was found by the last parse.
+    std::vector<uint64_t> foundOptions;
+
+    //! How often each option was found by the last parse, by option offset;
+    //! only the options that were found have an entry.
+    std::unordered_map<size_t, uint32_t> occurrenceCounts;
+
+    //! Handlers called by reparse() for options whose values changed, by option offset.
+    std::unordered_map<size_t, QCommandLineParser::OptionChangeHandler> optionChangeHandlers;
+
+    std::function<void()> positionalArgumentsChangeHandler;
+
+    //! Option constraints of all layers, gathered on the first parse after
+    //! the option table or the constraints of an option changed, then
+    //! checked in one pass. Each layer compiles its own constraints once
+    //! per change; only the names a layer could not resolve are resolved
+    //! here again.
+    struct Constraints
+    {
+        Constraints() : compiled(false), generation(0) { }
+
+        bool compiled;
+        size_t generation;
+        std::vector<std::shared_ptr<const OptionTableConstraints>> layers;
+        OptionTableConstraints resolved;
+        //! The layers bottom up, then resolved.
+        std::vector<const OptionTableConstraints *> checked;
+    };
+    Constraints constraints;
 
     std::vector<std::string> optionNames;
 
@@ -105,6 +346,17 @@ public:
 
     QCommandLineParser::OptionsAfterPositionalArgumentsMode optionsAfterPositionalArgumentsMode;
 
+    QCommandLineParser::LongOptionMatchingMode longOptionMatchingMode;
+
+    QCommandLineParser::PositionalArgumentExpansionMode positionalArgumentExpansionMode;
+    QCommandLineParser::ValueFileMode valueFileMode;
+
+    //! Receives glob matches instead of positionalArgumentList when set.
+    QCommandLineParser::GlobMatchHandler globMatchHandler;
+
+    //! Stores the strings of snapshots when set, each distinct string once.
+    std::shared_ptr<QCommandLineStringPool> stringPool;
+
     bool builtinVersionOption;
 
     bool builtinHelpOption;
@@ -112,14 +364,85 @@ public:
     bool needsParsing;
 };
 
-std::vector<std::string> QCommandLineParserPrivate::aliases(const std::string &optionName) const
+// Shares the options registered so far with an overlay, a snapshot or a
+// table. Nothing is copied or frozen here: sharing the layer is what keeps
+// this parser from modifying it again, see writableOptionTable().
+std::shared_ptr<const OptionTable> QCommandLineParserPrivate::shareOptionTable() const
 {
-    const NameHash_t::const_iterator it = nameHash.find(optionName);
-    if (it == nameHash.cend()) {
-        std::cerr << "QCommandLineParser: option not defined: \"" << optionName << "\"" << std::endl;
-        return std::vector<std::string>();
+    if (optionTable->isEmpty() && optionTable->base)
+        return optionTable->base;
+    return optionTable;
+}
+
+// Returns the top layer for adding to it, after putting a new layer on top
+// if the current one is shared.
+OptionTable *QCommandLineParserPrivate::writableOptionTable()
+{
+    if (optionTable.use_count() > 1)
+        optionTable = std::make_shared<OptionTable>(shareOptionTable());
+    return optionTable.get();
+}
+
+void QCommandLineParserPrivate::optionTableChanged()
+{
+    // Merge layers of similar size, so that sharing the table and adding
+    // options in turn keeps the number of layers logarithmic.
+    while (optionTable->base && optionTable->base->options.size() <= optionTable->options.size())
+        optionTable = std::make_shared<OptionTable>(*optionTable->base, *optionTable);
+    std::atomic_store(&optionTable->longNames, std::shared_ptr<const OptionTableLongNames>());
+    std::atomic_store(&optionTable->suggestions, std::shared_ptr<const OptionTableSuggestions>());
+    std::atomic_store(&optionTable->constraints, std::shared_ptr<const OptionTableConstraints>());
+    std::atomic_store(&optionTable->defaults, std::shared_ptr<const OptionTableDefaults>());
+    constraints.compiled = false;
+}
+
+/*!
+    \internal
+
+    Returns the values given for the option at \a optionOffset by the last
+    parse, or its default values, or null for an undefined option. Defaults
+    are cached until the next parse so that views into them stay valid.
+*/
+const std::vector<std::string> *QCommandLineParserPrivate::valueList(size_t optionOffset)
+{
+    if (optionOffset == std::string::npos)
+        return nullptr;
+    const auto it = optionValuesHash.find(optionOffset);
+    if (it != optionValuesHash.cend() && !it->second.empty())
+        return &it->second;
+    auto cached = defaultValuesHash.find(optionOffset);
+    if (cached == defaultValuesHash.end())
+        cached = defaultValuesHash.emplace(optionOffset, option(optionOffset).defaultValues()).first;
+    return &cached->second;
+}
+
+/*!
+    \internal
+
+    Returns the text \a value stands for. If the option at \a optionOffset
+    reads values from files, "@path" is replaced by a view of the mapped file
+    and "@@" by a literal "@"; the mapping is stored in \a mappedFile so
+    that the caller can keep it alive past the next parse.
+*/
+std::string_view QCommandLineParserPrivate::resolveValue(size_t optionOffset, const std::string &value,
+                                                         std::shared_ptr<const void> *mappedFile)
+{
+    if (value.empty() || value[0] != '@' || !readsValueFiles(optionOffset))
+        return value;
+    if (value.size() > 1 && value[1] == '@')
+        return std::string_view(value).substr(1);
+
+    const std::string path = value.substr(1);
+    std::shared_ptr<const MappedFile> &file = mappedFiles[path];
+    if (!file) {
+        // opened on first use unless parse() already checked it
+        file = std::make_shared<const MappedFile>(path);
+        if (file->error())
+            qCommandLineWarning({"QCommandLineParser: cannot read value file \"", path, "\": ", strerror(file->error())});
     }
-    return commandLineOptionList.at(it->second).names();
+    if (mappedFile)
+        *mappedFile = file;
+    return file->view();
 }
 
 QCommandLineParser::QCommandLineParser()
@@ -132,6 +455,36 @@ QCommandLineParser::~QCommandLineParser()
     delete d;
 }
 
+/*!
+    Returns a new parser that starts out with the options and settings of
+    this one and can add options of its own without affecting it.
+
+    The options registered so far are shared, not copied: creating an
+    overlay costs O(1) and the overlay only stores the options it adds. The
+    lookup structures over the shared options, such as the compiled option
+    constraints, are built once and shared as well. Both
+    parsers keep working independently; options added to this parser after
+    the call are not seen by the overlay. Parse results and change handlers
+    are not carried over.
+*/
+std::unique_ptr<QCommandLineParser> QCommandLineParser::createOverlay() const
+{
+    std::unique_ptr<QCommandLineParser> overlay(new QCommandLineParser);
+    QCommandLineParserPrivate *od = overlay->d;
+    od->optionTable = std::make_shared<OptionTable>(d->shareOptionTable());
+    od->description = d->description;
+    od->positionalArgumentDefinitions = d->positionalArgumentDefinitions;
+    od->singleDashWordOptionMode = d->singleDashWordOptionMode;
+    od->optionsAfterPositionalArgumentsMode = d->optionsAfterPositionalArgumentsMode;
+    od->longOptionMatchingMode = d->longOptionMatchingMode;
+    od->positionalArgumentExpansionMode = d->positionalArgumentExpansionMode;
+    od->valueFileMode = d->valueFileMode;
+    od->stringPool = d->stringPool;
+    od->builtinVersionOption = d->builtinVersionOption;
+    od->builtinHelpOption = d->builtinHelpOption;
+    return overlay;
+}
+
 void QCommandLineParser::setSingleDashWordOptionMode(QCommandLineParser::SingleDashWordOptionMode singleDashWordOptionMode)
 {
     d->singleDashWordOptionMode = singleDashWordOptionMode;
@@ -142,23 +495,89 @@ void QCommandLineParser::setOptionsAfterPositionalArgumentsMode(QCommandLinePars
     d->optionsAfterPositionalArgumentsMode = parsingMode;
 }
 
+/*!
+    Sets whether long options may be abbreviated to \a mode.
+
+    With MatchUniqueLongOptionPrefixes, \c{--verb} is accepted for
+    \c{--verbose} as long as no other option has a name starting with
+    \c{verb}. An exact match always wins over a prefix match.
+*/
+void QCommandLineParser::setLongOptionMatchingMode(QCommandLineParser::LongOptionMatchingMode mode)
+{
+    d->longOptionMatchingMode = mode;
+}
+
+/*!
+    Sets when \c{@path} values of options that allow values from files are
+    read to \a mode.
+
+    With ReadValueFilesOnFirstUse, the default, a file is opened when one of
+    its values is first read, through an accessor or snapshot(); one that
+    cannot be read gives an empty value and a warning. parse() never touches
+    the file system, so it cannot block on a FIFO.
+
+    With ReadValueFilesWhileParsing, every file is opened by parse(), and one
+    that cannot be read makes the parse fail with an InvalidValue error on
+    the argument naming it. Reading a pipe blocks parse() until the writer
+    closes it.
+
+    With IgnoreValueFiles, \c{@path} values are kept as text, as if no
+    option allowed values from files. Use this when the arguments come from
+    untrusted sources.
+
+    \sa QCommandLineOption::setValueFromFileAllowed()
+*/
+void QCommandLineParser::setValueFileMode(QCommandLineParser::ValueFileMode mode)
+{
+    d->valueFileMode = mode;
+}
+
+/*!
+    Sets how positional arguments are expanded to \a mode.
+
+    With ExpandGlobPatterns, every positional argument containing \c{*},
+    \c{?} or \c{[} is replaced by the paths it matches, as a shell would do,
+    so that patterns like \c{*.gz} also work where no shell expands them. A
+    \c{**} component matches any number of directories. Matches are sorted
+    by name within each directory, a directory coming before its contents,
+    and a pattern that matches nothing is kept as it is.
+
+    The directory tree is walked in parallel, after the arguments were parsed
+    without errors.
+
+    \sa setGlobMatchHandler()
+*/
+void QCommandLineParser::setPositionalArgumentExpansionMode(QCommandLineParser::PositionalArgumentExpansionMode mode)
+{
+    d->positionalArgumentExpansionMode = mode;
+}
+
+/*!
+    Passes the paths matched by glob patterns to \a handler, in order,
+    instead of adding them to positionalArguments(). Arguments that are not
+    patterns still end up in positionalArguments(). The handler is called
+    from parse() on the calling thread; pass an empty handler to collect
+    matches again.
+
+    \sa setPositionalArgumentExpansionMode()
+*/
+void QCommandLineParser::setGlobMatchHandler(const GlobMatchHandler &handler)
+{
+    d->globMatchHandler = handler;
+}
+
 bool QCommandLineParser::addOption(const QCommandLineOption &option)
 {
     const std::vector<std::string> optionNames = option.names();
 
     if (!optionNames.empty()) {
         for (const std::string &name : optionNames) {
-            auto search = d->nameHash.find(name);
-            if (search != d->nameHash.end())
+            if (d->findOption(name) != std::string::npos)
                 return false;
         }
 
-
-        d->commandLineOptionList.push_back(option);
-
-        const size_t offset = d->commandLineOptionList.size() - 1;
-        for (const std::string &name : optionNames)
-            d->nameHash.insert({name, offset});
+        d->writableOptionTable()->add(option, optionNames);
+        d->optionTableChanged();
 
         return true;
     }
@@ -175,6 +594,21 @@ bool QCommandLineParser::addOptions(const std::vector<QCommandLineOption> &optio
     return result;
 }
 
+/*!
+    Makes the options named in \a names mutually exclusive: parse() fails
+    with a ConflictingOptions error when more than one of them is given.
+
+    Returns \c false if fewer than two names are given.
+*/
+bool QCommandLineParser::addMutuallyExclusiveOptions(const std::vector<std::string> &names)
+{
+    if (names.size() < 2)
+        return false;
+    d->writableOptionTable()->exclusiveNames.push_back(names);
+    d->optionTableChanged();
+    return true;
+}
+
 QCommandLineOption QCommandLineParser::addVersionOption()
 {
     std::vector<std::string> list;
@@ -229,19 +663,164 @@ bool QCommandLineParser::parse(const std::vector<std::__cxx11::string> &argument
     return d->parse(arguments);
 }
 
+static size_t decodeUtf8(const unsigned char *data, size_t size, uint32_t *codePoint);
+
+// Returns the length in bytes of the code point at \a pos of \a text.
+static size_t codePointLength(const std::string &text, size_t pos)
+{
+    uint32_t codePoint;
+    return decodeUtf8(reinterpret_cast<const unsigned char *>(text.data()) + pos, text.size() - pos, &codePoint);
+}
+
+// Names of a single code point, such as "ü", are short options.
+static std::string dashedOptionName(const std::string &optionName)
+{
+    const bool shortName = !optionName.empty() && codePointLength(optionName, 0) == optionName.length();
+    return (shortName ? "-" : "--") + optionName;
+}
+
+static std::string didYouMean(const std::vector<std::string> &suggestions)
+{
+    std::string result = "Did you mean ";
+    for (size_t i = 0; i < suggestions.size(); ++i) {
+        if (i > 0)
+            result += i + 1 == suggestions.size() ? " or " : ", ";
+        result += "'" + dashedOptionName(suggestions.at(i)) + "'";
+    }
+    return result;
+}
+
+/*!
+    Parses \a arguments like parse(), then calls the change handlers of the
+    options whose presence or values differ from the previous parse.
+
+    Only options found by either parse are compared, so the work after parsing
+    is proportional to the options in use rather than to all registered ones.
+    If \a arguments fail to parse, the results of the previous parse are
+    kept, including its positional arguments and unknownOptionNames(), while
+    errors() and errorText() describe the failure; no handler is called and
+    \c false is returned.
+
+    \sa setOptionChangeHandler(), setPositionalArgumentsChangeHandler()
+*/
+bool QCommandLineParser::reparse(const std::vector<std::string> &arguments)
+{
+    return d->reparse(arguments);
+}
+
+/*!
+    Sets \a handler to be called by reparse() when \a option is added,
+    removed, or given different values. An empty handler removes it.
+*/
+void QCommandLineParser::setOptionChangeHandler(const QCommandLineOption &option, const OptionChangeHandler &handler)
+{
+    const std::vector<std::string> names = option.names();
+    const size_t offset = names.empty() ? std::string::npos : d->findOption(names.front());
+    if (offset == std::string::npos) {
+        qCommandLineWarning({"QCommandLineParser: option not defined: \"", names.empty() ? std::string() : names.front(), "\""});
+        return;
+    }
+    if (handler)
+        d->optionChangeHandlers[offset] = handler;
+    else
+        d->optionChangeHandlers.erase(offset);
+}
+
+/*!
+    Sets \a handler to be called by reparse() when the positional arguments change.
+*/
+void QCommandLineParser::setPositionalArgumentsChangeHandler(const std::function<void()> &handler)
+{
+    d->positionalArgumentsChangeHandler = handler;
+}
+
+/*!
+    Returns an error text for the user.
+    This should only be called when parse() returns \c false.
+
+    Every error found by the last parse is reported, one per line; unknown
+    options are summarized together. The text is only formatted here, parsing
+    itself just records errors().
+*/
 std::string QCommandLineParser::errorText() const
 {
-    if (!d->errorText.empty())
-        return d->errorText;
-    if (d->unknownOptionNames.size() == 1)
-        return "Unknown option '" + d->unknownOptionNames.front() + "'.";
-    if (d->unknownOptionNames.size() > 1) {
-        std::string result;
-        for (auto it = d->unknownOptionNames.begin(), end = d->unknownOptionNames.end(); it != end; ++it)
-            result += (*it);
-        return "Unknown options: " + result + ".";
+    std::string result;
+    // Taken from the errors, which a failed reparse() keeps while the
+    // previous unknownOptionNames() are restored
+    std::vector<std::string> unknownOptionNames;
+    for (const ParseError &error : d->errors) {
+        if (error.kind == UnknownOption) {
+            const auto failedArgument = d->failedArguments.find(error.argumentIndex);
+            if (failedArgument != d->failedArguments.cend())
+                unknownOptionNames.push_back(failedArgument->second.substr(error.byteOffset, error.length));
+            continue;
+        }
+        if (!result.empty())
+            result += '\n';
+        result += d->errorText(error);
     }
-    return std::string();
+
+    if (unknownOptionNames.size() == 1) {
+        const std::string &name = unknownOptionNames.front();
+        if (!result.empty())
+            result += '\n';
+        result += "Unknown option '" + name + "'.";
+        const std::vector<std::string> candidates = d->suggestions(name);
+        if (!candidates.empty())
+            result += " " + didYouMean(candidates) + "?";
+    } else if (unknownOptionNames.size() > 1) {
+        std::string hints;
+        if (!result.empty())
+            result += '\n';
+        result += "Unknown options: ";
+        // A name repeated many times, as in -xxxx, is looked up only once
+        std::unordered_set<std::string> hintedNames;
+        for (auto it = unknownOptionNames.begin(), end = unknownOptionNames.end(); it != end; ++it) {
+            if (it != unknownOptionNames.begin())
+                result += ", ";
+            result += *it;
+            if (!hintedNames.insert(*it).second)
+                continue;
+            const std::vector<std::string> candidates = d->suggestions(*it);
+            if (!candidates.empty())
+                hints += "\n" + didYouMean(candidates) + " instead of '" + *it + "'?";
+        }
+        result += "." + hints;
+    }
+    return result;
+}
+
+/*!
+    Returns the errors found by the last call to parse(), in the order in
+    which they occur on the command line.
+
+    \sa errorText()
+*/
+std::vector<QCommandLineParser::ParseError> QCommandLineParser::errors() const
+{
+    return d->errors;
+}
+
+/*!
+    Returns the human-readable message for \a error, one of the errors()
+    found by the last call to parse().
+*/
+std::string QCommandLineParser::errorText(const ParseError &error) const
+{
+    return d->errorText(error);
+}
+
+/*!
+    Returns the registered option names closest to \a unknownOptionName,
+    best match first, for building "did you mean" hints.
+
+    At most three names are returned, each naming a different option.
+
+    \sa unknownOptionNames(), errorText()
+*/
+std::vector<std::string> QCommandLineParser::suggestions(const std::string &unknownOptionName) const
+{
+    return d->suggestions(unknownOptionName);
 }
 
 enum MessageType { UsageMessage, ErrorMessage };
@@ -285,8 +864,16 @@ static void showParserMessage(const std::string &message, MessageType type) {
 void QCommandLineParser::process(const std::vector<std::__cxx11::string> &arguments)
 {
     if (!d->parse(arguments)) {
-        showParserMessage(errorText() + '\n', ErrorMessage);
-        ::exit(EXIT_FAILURE);
+        // --help and --version are honored even when required options or
+        // other constraints are not met, but not past a malformed command line
+        const bool helpOrVersionRequested = (d->builtinVersionOption && isSet("version"))
+                || (d->builtinHelpOption && isSet("help"));
+        const bool constraintErrorsOnly = std::all_of(d->errors.cbegin(), d->errors.cend(),
+                [](const ParseError &error) { return error.argumentIndex == std::string::npos; });
+        if (!helpOrVersionRequested || !constraintErrorsOnly) {
+            showParserMessage(errorText() + '\n', ErrorMessage);
+            ::exit(EXIT_FAILURE);
+        }
     }
 
     if (d->builtinVersionOption && isSet("version"))
@@ -316,75 +903,680 @@ process(args);
 void QCommandLineParserPrivate::checkParsed(const char *method)
 {
 if (needsParsing)
-std::cerr << "QCommandLineParser: call process() or parse() before " << method << std::endl;
+qCommandLineWarning({"QCommandLineParser: call process() or parse() before ", method});
 }
 
-bool QCommandLineParserPrivate::registerFoundOption(const std::string &optionName)
+/*!
+    \internal
+
+    Records \a value for the option at \a optionOffset as its occurrence
+    policy asks for.
+*/
+void QCommandLineParserPrivate::addValue(size_t optionOffset, std::string value)
 {
-auto search = nameHash.find(optionName);
-if (search != nameHash.end()) {
-optionNames.push_back(optionName);
-return true;
-} else {
-unknownOptionNames.push_back(optionName);
-return false;
+    std::vector<std::string> &values = optionValuesHash[optionOffset];
+    switch (option(optionOffset).occurrencePolicy()) {
+    case QCommandLineOption::AppendOccurrences:
+        values.push_back(std::move(value));
+        break;
+    case QCommandLineOption::KeepFirstOccurrence:
+        if (values.empty())
+            values.push_back(std::move(value));
+        break;
+    default:
+        if (values.empty())
+            values.push_back(std::move(value));
+        else
+            values.front() = std::move(value);
+        break;
+    }
 }
+
+/*!
+    \internal
+
+    With ReadValueFilesWhileParsing, opens the file named by \a value if it
+    is an "@path" value of the option at \a optionOffset, given at
+    \a byteOffset of the argument at \a argumentIndex. A file that cannot be
+    read is an InvalidValue error. Otherwise files are opened on first use.
+*/
+bool QCommandLineParserPrivate::loadValueFile(size_t optionOffset, const std::string &value,
+                                              size_t argumentIndex, size_t byteOffset)
+{
+    if (valueFileMode != QCommandLineParser::ReadValueFilesWhileParsing
+            || value.empty() || value[0] != '@' || (value.size() > 1 && value[1] == '@')
+            || !option(optionOffset).isValueFromFileAllowed())
+        return true;
+
+    const std::string path = value.substr(1);
+    std::shared_ptr<const MappedFile> &file = mappedFiles[path];
+    if (!file)
+        file = std::make_shared<const MappedFile>(path);
+    if (!file->error())
+        return true;
+    addError(QCommandLineParser::InvalidValue, argumentIndex, byteOffset + 1, path.length(), optionOffset,
+             size_t(file->error()));
+    return false;
 }
 
-bool QCommandLineParserPrivate::parseOptionValue(const std::string &optionName, const std::string &argument,
-std::vector<std::string>::const_iterator *argumentIterator, std::vector<std::string>::const_iterator argsEnd)
-{
-const char assignChar('=');
-const NameHash_t::const_iterator nameHashIt = nameHash.find(optionName);
-if (nameHashIt!=nameHash.end()) {
-const size_t assignPos = argument.find(assignChar);
-const NameHash_t::mapped_type optionOffset = (*nameHashIt).second;
-const bool withValue = !commandLineOptionList.at(optionOffset).valueName().empty();
-if (withValue) {
-if (assignPos==std::string::npos) {
-++(*argumentIterator);
-if (*argumentIterator == argsEnd) {
-errorText = "Missing value after '" + argument + "%1" + "'.";
-return false;
+void QCommandLineParserPrivate::addError(QCommandLineParser::ParseErrorKind kind, size_t argumentIndex,
+                                         size_t byteOffset, size_t length, size_t optionOffset,
+                                         size_t detail)
+{
+    const QCommandLineParser::ParseError error = { kind, argumentIndex, byteOffset, length, optionOffset, detail };
+    errors.push_back(error);
 }
-optionValuesHash[optionOffset].push_back(*(*argumentIterator));
-}else{
-optionValuesHash[optionOffset].push_back(argument.substr(assignPos + 1, argument.size()));
+
+static inline void setBit(std::vector<uint64_t> *bits, size_t index)
+{
+    (*bits)[index / 64] |= uint64_t(1) << (index % 64);
 }
-}else{if(assignPos != std::string::npos) { errorText = "Unexpected value after '" + argument.substr(assignPos) + "%1" + "'.";
-return false;
+
+static inline bool testBit(const std::vector<uint64_t> &bits, size_t index)
+{
+    return bits[index / 64] & (uint64_t(1) << (index % 64));
 }
+
+static bool parseInteger(const std::string &text, long long *value)
+{
+    if (text.empty())
+        return false;
+    char *end = nullptr;
+    errno = 0;
+    *value = strtoll(text.c_str(), &end, 10);
+    return errno == 0 && *end == '\0';
 }
+
+std::string QCommandLineParserPrivate::optionDisplayName(size_t optionOffset) const
+{
+    const std::vector<std::string> names = option(optionOffset).names();
+    return names.empty() ? std::string() : dashedOptionName(names.front());
 }
-return true;
+
+// Compiles the constraints of the options and mutually exclusive groups of
+// \a table's own layer. Names are looked up in the layer and the layers below.
+static std::shared_ptr<const OptionTableConstraints> compileLayerConstraints(const OptionTable &table,
+                                                                            size_t generation)
+{
+    std::shared_ptr<OptionTableConstraints> constraints = std::make_shared<OptionTableConstraints>();
+    constraints->generation = generation;
+    for (size_t i = 0; i < table.options.size(); ++i) {
+        const size_t offset = table.baseCount + i;
+        const QCommandLineOption &option = table.options.at(i);
+        if (option.isRequired())
+            constraints->required.push_back(offset);
+        for (const std::string &name : option.dependencies()) {
+            const size_t dependency = table.find(name);
+            if (dependency != std::string::npos)
+                constraints->dependencies.push_back({offset, dependency});
+            else
+                constraints->unresolvedDependencies.push_back({offset, name});
+        }
+        if (option.hasValueRange()) {
+            const OptionTableConstraints::ValueRange range = { offset, option.minimumValue(), option.maximumValue() };
+            constraints->valueRanges.push_back(range);
+        }
+        std::vector<std::string> allowedValues = option.allowedValues();
+        if (!allowedValues.empty()) {
+            std::sort(allowedValues.begin(), allowedValues.end());
+            constraints->allowedValues.push_back({offset, allowedValues});
+        }
+    }
+
+    for (const std::vector<std::string> &names : table.exclusiveNames) {
+        std::vector<size_t> group;
+        for (const std::string &name : names) {
+            const size_t offset = table.find(name);
+            if (offset == std::string::npos)
+                break;
+            group.push_back(offset);
+        }
+        if (group.size() < names.size()) {
+            constraints->unresolvedGroups.push_back(names);
+            continue;
+        }
+        std::sort(group.begin(), group.end());
+        group.erase(std::unique(group.begin(), group.end()), group.end());
+        if (group.size() > 1)
+            constraints->exclusiveGroups.push_back(group);
+    }
+    return constraints;
 }
 
-bool QCommandLineParserPrivate::parse(const std::vector<std::string> &args)
+void QCommandLineParserPrivate::compileConstraints()
 {
-    needsParsing = false;
-    bool error = false;
+    // read first, so that a change while compiling is seen by the next parse
+    const size_t generation = qCommandLineConstraintGeneration();
+    constraints = Constraints();
+    OptionTableConstraints &resolved = constraints.resolved;
+
+    const auto resolve = [this](const std::string &name, size_t *offset) {
+        *offset = findOption(name);
+        if (*offset == std::string::npos) {
+            qCommandLineWarning({"QCommandLineParser: constraint refers to undefined option \"", name, "\""});
+            return false;
+        }
+        return true;
+    };
 
-    const std::string doubleDashString("--");
-    const char dashChar('-');
-    const char assignChar('=');
+    for (const OptionTable *table = optionTable.get(); table; table = table->base.get()) {
+        std::shared_ptr<const OptionTableConstraints> layer = std::atomic_load(&table->constraints);
+        if (!layer || layer->generation != generation) {
+            layer = compileLayerConstraints(*table, generation);
+            std::atomic_store(&table->constraints, layer);
+        }
+        for (const auto &unresolved : layer->unresolvedDependencies) {
+            size_t dependency;
+            if (resolve(unresolved.second, &dependency))
+                resolved.dependencies.push_back({unresolved.first, dependency});
+        }
+        for (const std::vector<std::string> &names : layer->unresolvedGroups) {
+            std::vector<size_t> group;
+            for (const std::string &name : names) {
+                size_t offset;
+                if (resolve(name, &offset))
+                    group.push_back(offset);
+            }
+            std::sort(group.begin(), group.end());
+            group.erase(std::unique(group.begin(), group.end()), group.end());
+            if (group.size() > 1)
+                resolved.exclusiveGroups.push_back(group);
+        }
+        constraints.layers.push_back(layer);
+    }
+    // check the lowest offsets first
+    for (auto it = constraints.layers.crbegin(); it != constraints.layers.crend(); ++it)
+        constraints.checked.push_back(it->get());
+    constraints.checked.push_back(&constraints.resolved);
 
-    bool forcePositional = false;
-    errorText.clear();
-    positionalArgumentList.clear();
-    optionNames.clear();
-    unknownOptionNames.clear();
-    optionValuesHash.clear();
+    constraints.compiled = true;
+    constraints.generation = generation;
+}
 
-    if (args.empty()) {
-        std::cerr << "QCommandLineParser: argument list cannot be empty, it should contain at least the executable name" << std::endl;
-        return false;
+bool QCommandLineParserPrivate::checkConstraints()
+{
+    if (!constraints.compiled || constraints.generation != qCommandLineConstraintGeneration())
+        compileConstraints();
+    const size_t errorCount = errors.size();
+
+    const std::vector<const OptionTableConstraints *> &layers = constraints.checked;
+    for (const OptionTableConstraints *layer : layers) {
+        for (size_t offset : layer->required) {
+            if (!testBit(foundOptions, offset))
+                addError(QCommandLineParser::MissingRequiredOption, std::string::npos, 0, 0, offset);
+        }
     }
 
-    std::vector<std::string>::const_iterator argumentIterator = args.begin();
-    ++argumentIterator; // skip executable name
+    for (const OptionTableConstraints *layer : layers) {
+        for (const std::vector<size_t> &group : layer->exclusiveGroups) {
+            size_t first = std::string::npos;
+            for (size_t offset : group) {
+                if (!testBit(foundOptions, offset))
+                    continue;
+                if (first == std::string::npos)
+                    first = offset;
+                else
+                    addError(QCommandLineParser::ConflictingOptions, std::string::npos, 0, 0, first, offset);
+            }
+        }
+    }
 
-    for (; argumentIterator != args.end() ; ++argumentIterator) {
-        std::string argument = *argumentIterator;
+    for (const OptionTableConstraints *layer : layers) {
+        for (const auto &dependency : layer->dependencies) {
+            if (testBit(foundOptions, dependency.first) && !testBit(foundOptions, dependency.second))
+                addError(QCommandLineParser::MissingDependency, std::string::npos, 0, 0, dependency.first, dependency.second);
+        }
+    }
+
+    for (const OptionTableConstraints *layer : layers) {
+        for (const OptionTableConstraints::ValueRange &range : layer->valueRanges) {
+            const auto it = optionValuesHash.find(range.optionOffset);
+            if (it == optionValuesHash.cend())
+                continue;
+            for (size_t i = 0; i < it->second.size(); ++i) {
+                long long value;
+                if (!parseInteger(it->second.at(i), &value))
+                    addError(QCommandLineParser::InvalidValue, std::string::npos, 0, 0, range.optionOffset, i);
+                else if (value < range.minimum || value > range.maximum)
+                    addError(QCommandLineParser::ValueOutOfRange, std::string::npos, 0, 0, range.optionOffset, i);
+            }
+        }
+    }
+
+    for (const OptionTableConstraints *layer : layers) {
+        for (const auto &allowed : layer->allowedValues) {
+            const auto it = optionValuesHash.find(allowed.first);
+            if (it == optionValuesHash.cend())
+                continue;
+            for (size_t i = 0; i < it->second.size(); ++i) {
+                if (!std::binary_search(allowed.second.cbegin(), allowed.second.cend(), it->second.at(i)))
+                    addError(QCommandLineParser::InvalidValue, std::string::npos, 0, 0, allowed.first, i);
+            }
+        }
+    }
+
+    return errors.size() == errorCount;
+}
+
+std::string QCommandLineParserPrivate::errorText(const QCommandLineParser::ParseError &error)
+{
+    if (error.argumentIndex == std::string::npos) {
+        if (error.optionOffset >= optionCount())
+            return std::string();
+        const std::string name = optionDisplayName(error.optionOffset);
+        switch (error.kind) {
+        case QCommandLineParser::MissingRequiredOption:
+            return "Missing required option '" + name + "'.";
+        case QCommandLineParser::MissingDependency:
+            return "Option '" + name + "' requires '" + optionDisplayName(error.detail) + "'.";
+        case QCommandLineParser::ConflictingOptions:
+            return "Options '" + name + "' and '" + optionDisplayName(error.detail) + "' are mutually exclusive.";
+        case QCommandLineParser::ValueOutOfRange:
+        case QCommandLineParser::InvalidValue:
+        {
+            const QCommandLineOption &option = optionTable->at(error.optionOffset);
+            const std::string &value = optionValuesHash[error.optionOffset].at(error.detail);
+            const std::vector<std::string> allowedValues = option.allowedValues();
+            const bool allowed = allowedValues.empty()
+                    || std::find(allowedValues.cbegin(), allowedValues.cend(), value) != allowedValues.cend();
+            std::string result = error.kind == QCommandLineParser::ValueOutOfRange
+                    ? "Value '" + value + "' for option '" + name + "' is out of range, expected "
+                    : "Invalid value '" + value + "' for option '" + name + "', expected ";
+            if (allowed) {
+                return result + "an integer from " + std::to_string(option.minimumValue())
+                        + " to " + std::to_string(option.maximumValue()) + ".";
+            }
+            result += "one of: ";
+            for (auto it = allowedValues.cbegin(); it != allowedValues.cend(); ++it)
+                result += (it == allowedValues.cbegin() ? "" : ", ") + *it;
+            return result + ".";
+        }
+        default:
+            return std::string();
+        }
+    }
+
+    const auto failedArgument = failedArguments.find(error.argumentIndex);
+    if (failedArgument == failedArguments.cend())
+        return std::string();
+    const std::string text = failedArgument->second.substr(error.byteOffset, error.length);
+
+    switch (error.kind) {
+    case QCommandLineParser::UnknownOption:
+    {
+        std::string result = "Unknown option '" + text + "'.";
+        const std::vector<std::string> candidates = suggestions(text);
+        if (!candidates.empty())
+            result += " " + didYouMean(candidates) + "?";
+        return result;
+    }
+    case QCommandLineParser::AmbiguousOption:
+    {
+        std::string result = "Ambiguous option '" + text + "', could be: ";
+        const std::vector<std::string> candidates = longOptionCandidates(text);
+        for (auto it = candidates.cbegin(); it != candidates.cend(); ++it)
+            result += (it == candidates.cbegin() ? "--" : ", --") + *it;
+        return result + ".";
+    }
+    case QCommandLineParser::MissingValue:
+        return "Missing value after '" + text + "'.";
+    case QCommandLineParser::UnexpectedValue:
+        return "Unexpected value after '" + text + "'.";
+    case QCommandLineParser::RepeatedOption:
+        return "Option '" + text + "' can only be given once.";
+    case QCommandLineParser::InvalidValue:
+        return "Cannot read value file '" + text + "' for option '" + optionDisplayName(error.optionOffset)
+                + "': " + strerror(int(error.detail)) + ".";
+    default:
+        return std::string();
+    }
+}
+
+bool QCommandLineParserPrivate::registerFoundOption(const std::string &optionName, size_t argumentIndex, size_t byteOffset)
+{
+    const size_t offset = findOption(optionName);
+    if (offset != std::string::npos) {
+        uint32_t &count = occurrenceCounts[offset];
+        if (count != UINT32_MAX)
+            ++count;
+        const QCommandLineOption::OccurrencePolicy policy = option(offset).occurrencePolicy();
+        if (count > 1 && policy == QCommandLineOption::RejectRepeatedOccurrences) {
+            addError(QCommandLineParser::RepeatedOption, argumentIndex, byteOffset, optionName.length(), offset);
+            return false;
+        }
+        // Repeats of a counted or single-valued option take no extra memory
+        if (count == 1 || policy == QCommandLineOption::AppendOccurrences)
+            optionNames.push_back(optionName);
+        setBit(&foundOptions, offset);
+        return true;
+    } else {
+        unknownOptionNames.push_back(optionName);
+        addError(QCommandLineParser::UnknownOption, argumentIndex, byteOffset, optionName.length());
+        return false;
+    }
+}
+
+static std::shared_ptr<const OptionTableLongNames> longNames(const OptionTable *table)
+{
+    return layerCache(&table->longNames, [table]() {
+        std::shared_ptr<OptionTableLongNames> index = std::make_shared<OptionTableLongNames>();
+        for (const NameHash_t::value_type &entry : table->nameHash) {
+            if (entry.first.length() > 1)
+                index->names.push_back(entry);
+        }
+        std::sort(index->names.begin(), index->names.end());
+        return index;
+    });
+}
+
+bool QCommandLineParserPrivate::expandLongOptionName(std::string *optionName)
+{
+    if (longOptionMatchingMode == QCommandLineParser::MatchExactLongOptions
+            || optionName->empty() || findOption(*optionName) != std::string::npos)
+        return true;
+
+    const std::string &prefix = *optionName;
+    const auto hasPrefix = [&prefix](const LongNameIndex_t::value_type &entry) {
+        return entry.first.compare(0, prefix.length(), prefix) == 0;
+    };
+    // Aliases of the same option may share the prefix; only a second option is ambiguous.
+    std::string match;
+    size_t matchOffset = std::string::npos;
+    for (const OptionTable *table = optionTable.get(); table; table = table->base.get()) {
+        const std::shared_ptr<const OptionTableLongNames> index = longNames(table);
+        for (auto it = std::lower_bound(index->names.cbegin(), index->names.cend(), LongNameIndex_t::value_type(prefix, 0));
+             it != index->names.cend() && hasPrefix(*it); ++it) {
+            if (matchOffset != std::string::npos && it->second != matchOffset)
+                return false;
+            if (matchOffset == std::string::npos || it->first < match) {
+                match = it->first;
+                matchOffset = it->second;
+            }
+        }
+    }
+    if (matchOffset != std::string::npos)
+        *optionName = match;
+    return true; // an unmatched name is reported as unknown by registerFoundOption
+}
+
+// Returns the long names starting with \a prefix, one name per option.
+std::vector<std::string> QCommandLineParserPrivate::longOptionCandidates(const std::string &prefix)
+{
+    LongNameIndex_t matches;
+    for (const OptionTable *table = optionTable.get(); table; table = table->base.get()) {
+        const std::shared_ptr<const OptionTableLongNames> index = longNames(table);
+        for (auto it = std::lower_bound(index->names.cbegin(), index->names.cend(), LongNameIndex_t::value_type(prefix, 0));
+             it != index->names.cend() && it->first.compare(0, prefix.length(), prefix) == 0; ++it) {
+            matches.push_back(*it);
+        }
+    }
+    std::sort(matches.begin(), matches.end());
+
+    std::vector<std::string> result;
+    std::vector<size_t> options;
+    for (const LongNameIndex_t::value_type &entry : matches) {
+        if (std::find(options.cbegin(), options.cend(), entry.second) != options.cend())
+            continue;
+        options.push_back(entry.second);
+        result.push_back(entry.first);
+    }
+    return result;
+}
+
+static const size_t MaxSuggestions = 3;
+
+// Packs the trigram starting at \a pos of \a name padded with a '\1' on both
+// ends, so that names shorter than three characters still have trigrams.
+static uint32_t trigramAt(const std::string &name, size_t pos)
+{
+    uint32_t trigram = 0;
+    for (size_t i = pos; i < pos + 3; ++i) {
+        const unsigned char c = (i == 0 || i > name.length()) ? 1 : name.at(i - 1);
+        trigram = (trigram << 8) | c;
+    }
+    return trigram;
+}
+
+static std::vector<uint32_t> trigrams(const std::string &name)
+{
+    std::vector<uint32_t> result;
+    result.reserve(name.length());
+    for (size_t pos = 0; pos < name.length(); ++pos)
+        result.push_back(trigramAt(name, pos));
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+// Levenshtein distance between \a pattern (at most 64 characters) and \a text,
+// using Myers' bit-parallel algorithm as formulated by Hyyro. Returns a value
+// greater than \a maxDistance as soon as the distance is known to exceed it.
+static size_t boundedEditDistance(const std::string &pattern, const std::string &text, size_t maxDistance)
+{
+    const size_t m = pattern.length();
+    if (m == 0)
+        return text.length();
+
+    uint64_t peq[256] = {};
+    for (size_t i = 0; i < m; ++i)
+        peq[static_cast<unsigned char>(pattern.at(i))] |= uint64_t(1) << i;
+
+    const uint64_t last = uint64_t(1) << (m - 1);
+    uint64_t pv = m == 64 ? ~uint64_t(0) : (uint64_t(1) << m) - 1;
+    uint64_t mv = 0;
+    size_t score = m;
+    for (size_t j = 0; j < text.length(); ++j) {
+        const uint64_t eq = peq[static_cast<unsigned char>(text.at(j))];
+        const uint64_t xv = eq | mv;
+        const uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        if (ph & last)
+            ++score;
+        else if (mh & last)
+            --score;
+        // each remaining column can lower the score by at most one
+        if (score > maxDistance + (text.length() - j - 1))
+            return maxDistance + 1;
+        // the implicit row 0 of the matrix grows by one per text column
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    return score;
+}
+
+static std::shared_ptr<const OptionTableSuggestions> suggestionIndex(const OptionTable *table)
+{
+    return layerCache(&table->suggestions, [table]() {
+        std::shared_ptr<OptionTableSuggestions> index = std::make_shared<OptionTableSuggestions>();
+        index->names.assign(table->nameHash.cbegin(), table->nameHash.cend());
+        std::sort(index->names.begin(), index->names.end());
+        for (uint32_t id = 0; id < index->names.size(); ++id) {
+            const std::string &name = index->names.at(id).first;
+            if (index->namesByLength.size() <= name.length())
+                index->namesByLength.resize(name.length() + 1);
+            index->namesByLength[name.length()].push_back(id);
+            for (uint32_t trigram : trigrams(name))
+                index->namesByTrigram[trigram].push_back(id);
+        }
+        return index;
+    });
+}
+
+std::vector<std::string> QCommandLineParserPrivate::suggestions(const std::string &unknownName)
+{
+    const size_t length = unknownName.length();
+    if (length == 0 || length > 64)
+        return std::vector<std::string>();
+
+    const size_t maxDistance = length <= 4 ? 1 : length <= 8 ? 2 : 3;
+
+    // q-gram lemma: every edit destroys at most three of the query's distinct
+    // trigrams, so a candidate within maxDistance must share the rest.
+    const std::vector<uint32_t> queryTrigrams = trigrams(unknownName);
+    const size_t minSharedTrigrams = queryTrigrams.size() > 3 * maxDistance
+            ? queryTrigrams.size() - 3 * maxDistance : 0;
+
+    struct Candidate
+    {
+        size_t distance;
+        const std::pair<std::string, size_t> *entry;
+    };
+    std::vector<Candidate> candidates;
+    std::vector<std::shared_ptr<const OptionTableSuggestions>> indexes;
+    for (const OptionTable *table = optionTable.get(); table; table = table->base.get()) {
+        indexes.push_back(suggestionIndex(table));
+        const OptionTableSuggestions &index = *indexes.back();
+
+        std::vector<uint8_t> sharedTrigrams;
+        if (minSharedTrigrams > 0) {
+            sharedTrigrams.resize(index.names.size());
+            for (uint32_t trigram : queryTrigrams) {
+                const auto it = index.namesByTrigram.find(trigram);
+                if (it == index.namesByTrigram.cend())
+                    continue;
+                for (uint32_t id : it->second) {
+                    if (sharedTrigrams[id] < 255)
+                        ++sharedTrigrams[id];
+                }
+            }
+        }
+
+        const size_t minLength = length > maxDistance ? length - maxDistance : 1;
+        const size_t maxLength = std::min(length + maxDistance + 1, index.namesByLength.size());
+        for (size_t candidateLength = minLength; candidateLength < maxLength; ++candidateLength) {
+            for (uint32_t id : index.namesByLength.at(candidateLength)) {
+                if (minSharedTrigrams > 0 && sharedTrigrams.at(id) < minSharedTrigrams)
+                    continue;
+                const size_t distance = boundedEditDistance(unknownName, index.names.at(id).first, maxDistance);
+                if (distance <= maxDistance)
+                    candidates.push_back({distance, &index.names.at(id)});
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.entry->first < b.entry->first);
+    });
+
+    std::vector<std::string> result;
+    std::vector<size_t> suggestedOptions;
+    for (const Candidate &candidate : candidates) {
+        const auto &entry = *candidate.entry;
+        if (std::find(suggestedOptions.cbegin(), suggestedOptions.cend(), entry.second) != suggestedOptions.cend())
+            continue; // already suggested through an alias
+        suggestedOptions.push_back(entry.second);
+        result.push_back(entry.first);
+        if (result.size() == MaxSuggestions)
+            break;
+    }
+    return result;
+}
+
+/*!
+    \internal
+
+    Steps over the value of an occurrence of \a optionName that was rejected,
+    so that a separate value argument is not taken for a positional argument.
+*/
+void QCommandLineParserPrivate::skipOptionValue(const std::string &optionName, const std::string &argument,
+                                                std::vector<std::string>::const_iterator *argumentIterator,
+                                                std::vector<std::string>::const_iterator argsEnd)
+{
+    const size_t optionOffset = findOption(optionName);
+    if (optionOffset == std::string::npos || option(optionOffset).valueName().empty()
+            || argument.find('=') != std::string::npos)
+        return;
+    if (*argumentIterator + 1 != argsEnd)
+        ++(*argumentIterator);
+}
+
+/*!
+    \internal
+
+    Steps over the value of an ambiguous long option \a prefix if one of the
+    options it could stand for takes a value, so that \c{--ver value} does
+    not leave \c value behind as a positional argument.
+*/
+void QCommandLineParserPrivate::skipAmbiguousOptionValue(const std::string &prefix, const std::string &argument,
+                                                         std::vector<std::string>::const_iterator *argumentIterator,
+                                                         std::vector<std::string>::const_iterator argsEnd)
+{
+    for (const std::string &candidate : longOptionCandidates(prefix)) {
+        if (!option(findOption(candidate)).valueName().empty()) {
+            skipOptionValue(candidate, argument, argumentIterator, argsEnd);
+            return;
+        }
+    }
+}
+
+bool QCommandLineParserPrivate::parseOptionValue(const std::string &optionName, const std::string &argument,
+                                                 std::vector<std::string>::const_iterator *argumentIterator,
+                                                 std::vector<std::string>::const_iterator argsEnd, size_t argumentIndex)
+{
+    const char assignChar('=');
+    const size_t optionOffset = findOption(optionName);
+    if (optionOffset != std::string::npos) {
+        const size_t assignPos = argument.find(assignChar);
+        const bool withValue = !option(optionOffset).valueName().empty();
+        if (withValue) {
+            if (assignPos == std::string::npos) {
+                ++(*argumentIterator);
+                if (*argumentIterator == argsEnd) {
+                    addError(QCommandLineParser::MissingValue, argumentIndex, 0, argument.length(), optionOffset);
+                    return false;
+                }
+                const std::string &value = *(*argumentIterator);
+                if (!loadValueFile(optionOffset, value, argumentIndex + 1, 0))
+                    return false;
+                addValue(optionOffset, value);
+            } else {
+                const std::string value = argument.substr(assignPos + 1, argument.size());
+                if (!loadValueFile(optionOffset, value, argumentIndex, assignPos + 1))
+                    return false;
+                addValue(optionOffset, value);
+            }
+        } else if (assignPos != std::string::npos) {
+            addError(QCommandLineParser::UnexpectedValue, argumentIndex, 0, assignPos, optionOffset);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool QCommandLineParserPrivate::parse(const std::vector<std::string> &args)
+{
+    needsParsing = false;
+    bool error = false;
+
+    const std::string doubleDashString("--");
+    const char dashChar('-');
+    const char assignChar('=');
+
+    bool forcePositional = false;
+    errors.clear();
+    failedArguments.clear();
+    positionalArgumentList.clear();
+    optionNames.clear();
+    unknownOptionNames.clear();
+    optionValuesHash.clear();
+    defaultValuesHash.clear();
+    mappedFiles.clear();
+    foundOptions.assign((optionCount() + 63) / 64, 0);
+    occurrenceCounts.clear();
+
+    if (args.empty()) {
+        qCommandLineWarning({"QCommandLineParser: argument list cannot be empty, it should contain at least the executable name"});
+        return false;
+    }
+
+    std::vector<std::string>::const_iterator argumentIterator = args.begin();
+    ++argumentIterator; // skip executable name
+
+    for (; argumentIterator != args.end() ; ++argumentIterator) {
+        const std::string &argument = *argumentIterator;
+        const size_t argumentIndex = argumentIterator - args.begin();
 
         if (forcePositional) {
             positionalArgumentList.push_back(argument);
@@ -392,10 +1584,15 @@ bool QCommandLineParserPrivate::parse(const std::vector<std::string> &args)
             if (argument.length() > 2) {
                 std::string optionName = argument.substr(2, argument.size());
                 optionName = optionName.substr(0, optionName.find(assignChar));
-                if (registerFoundOption(optionName)) {
-                    if (!parseOptionValue(optionName, argument, &argumentIterator, args.end()))
+                if (!expandLongOptionName(&optionName)) {
+                    addError(QCommandLineParser::AmbiguousOption, argumentIndex, 2, optionName.length());
+                    skipAmbiguousOptionValue(optionName, argument, &argumentIterator, args.end());
+                    error = true;
+                } else if (registerFoundOption(optionName, argumentIndex, 2)) {
+                    if (!parseOptionValue(optionName, argument, &argumentIterator, args.end(), argumentIndex))
                         error = true;
                 } else {
+                    skipOptionValue(optionName, argument, &argumentIterator, args.end());
                     error = true;
                 }
             } else {
@@ -411,39 +1608,61 @@ bool QCommandLineParserPrivate::parse(const std::vector<std::string> &args)
             {
                 std::string optionName;
                 bool valueFound = false;
-for (size_t pos = 1 ; pos < argument.size(); ++pos) {
-optionName = argument.substr(pos, 1);
-if (!registerFoundOption(optionName)) {
+                bool valueRejected = false;
+// Each short option is one code point, so "-ü" is the option "ü"
+for (size_t pos = 1, length; pos < argument.size(); pos += length) {
+length = codePointLength(argument, pos);
+optionName = argument.substr(pos, length);
+const size_t next = pos + length;
+if (!registerFoundOption(optionName, argumentIndex, pos)) {
 error = true;
+// A rejected repetition still takes the rest of the argument, or the next one, as its value
+const size_t optionOffset = findOption(optionName);
+if (optionOffset != std::string::npos && !option(optionOffset).valueName().empty()) {
+valueFound = next < argument.size();
+valueRejected = true;
+break;
+}
 } else {
-const NameHash_t::const_iterator nameHashIt = nameHash.find(optionName);
-const NameHash_t::mapped_type optionOffset = (*nameHashIt).second;
-const bool withValue = !commandLineOptionList.at(optionOffset).valueName().empty();
+const size_t optionOffset = findOption(optionName);
+const bool withValue = !option(optionOffset).valueName().empty();
 if (withValue) {
-if (pos + 1 < argument.size()) {
-if (argument.at(pos + 1) == assignChar)
-++pos;
-optionValuesHash[optionOffset].push_back(argument.substr(pos + 1, argument.size()));
+if (next < argument.size()) {
+const size_t valueStart = argument.at(next) == assignChar ? next + 1 : next;
+const std::string value = argument.substr(valueStart, argument.size());
+if (loadValueFile(optionOffset, value, argumentIndex, valueStart))
+addValue(optionOffset, value);
+else
+error = true;
 valueFound = true;
 }
 break;
 }
-if (pos + 1 < argument.size() && argument.at(pos + 1) == assignChar)
+if (next < argument.size() && argument.at(next) == assignChar)
 break;
                     }
                 }
-                if (!valueFound && !parseOptionValue(optionName, argument, &argumentIterator, args.end()))
+                if (valueRejected) {
+                    if (!valueFound)
+                        skipOptionValue(optionName, argument, &argumentIterator, args.end());
+                } else if (!valueFound && !parseOptionValue(optionName, argument, &argumentIterator, args.end(), argumentIndex)) {
                     error = true;
+                }
                 break;
             }
             case QCommandLineParser::ParseAsLongOptions:
             {
                 std::string optionName = argument.substr(1, argument.size());
                 optionName = optionName.substr(0, optionName.find(assignChar));
-                if (registerFoundOption(optionName)) {
-                    if (!parseOptionValue(optionName, argument, &argumentIterator, args.end()))
+                if (!expandLongOptionName(&optionName)) {
+                    addError(QCommandLineParser::AmbiguousOption, argumentIndex, 1, optionName.length());
+                    skipAmbiguousOptionValue(optionName, argument, &argumentIterator, args.end());
+                    error = true;
+                } else if (registerFoundOption(optionName, argumentIndex, 1)) {
+                    if (!parseOptionValue(optionName, argument, &argumentIterator, args.end(), argumentIndex))
                         error = true;
                 } else {
+                    skipOptionValue(optionName, argument, &argumentIterator, args.end());
                     error = true;
                 }
                 break;
@@ -457,31 +1676,237 @@ break;
         if (argumentIterator == args.end())
             break;
     }
+    if (!checkConstraints())
+        error = true;
+    if (error) {
+        // only the arguments the errors point into, so that a failing parse
+        // does not pay for copying the whole command line; try_emplace()
+        // copies each only once, however many errors point into it
+        for (const QCommandLineParser::ParseError &parseError : errors) {
+            if (parseError.argumentIndex != std::string::npos)
+                failedArguments.try_emplace(parseError.argumentIndex, args.at(parseError.argumentIndex));
+        }
+    } else if (positionalArgumentExpansionMode == QCommandLineParser::ExpandGlobPatterns)
+        expandPositionalArguments();
     return !error;
 }
 
+/*!
+    \internal
+
+    Replaces glob patterns in the positional arguments by their matches, or
+    hands the matches to the glob match handler.
+*/
+void QCommandLineParserPrivate::expandPositionalArguments()
+{
+    std::vector<std::string> arguments;
+    arguments.swap(positionalArgumentList);
+    positionalArgumentList.reserve(arguments.size());
+    for (std::string &argument : arguments) {
+        size_t matches = 0;
+        if (qCommandLineIsGlobPattern(argument)) {
+            if (globMatchHandler) {
+                matches = qCommandLineExpandGlob(argument, [this](std::string &&path) {
+                    globMatchHandler(path);
+                });
+            } else {
+                matches = qCommandLineExpandGlob(argument, [this](std::string &&path) {
+                    positionalArgumentList.push_back(std::move(path));
+                });
+            }
+        }
+        if (matches == 0)
+            positionalArgumentList.push_back(std::move(argument));
+    }
+}
+
+bool QCommandLineParserPrivate::reparse(const std::vector<std::string> &args)
+{
+    // Everything parse() resets but the errors, which describe a failure
+    std::unordered_map<size_t, std::vector<std::string>> previousValues;
+    std::unordered_map<size_t, std::vector<std::string>> previousDefaults;
+    std::unordered_map<std::string, std::shared_ptr<const MappedFile>> previousFiles;
+    std::vector<uint64_t> previousFound;
+    std::unordered_map<size_t, uint32_t> previousCounts;
+    std::vector<std::string> previousOptionNames;
+    std::vector<std::string> previousPositionals;
+    std::vector<std::string> previousUnknownNames;
+    const auto swapResults = [&] {
+        previousValues.swap(optionValuesHash);
+        previousDefaults.swap(defaultValuesHash);
+        previousFiles.swap(mappedFiles);
+        previousFound.swap(foundOptions);
+        previousCounts.swap(occurrenceCounts);
+        previousOptionNames.swap(optionNames);
+        previousPositionals.swap(positionalArgumentList);
+        previousUnknownNames.swap(unknownOptionNames);
+    };
+
+    swapResults();
+    if (!parse(args)) {
+        swapResults();
+        return false;
+    }
+
+    static const std::vector<std::string> noValues;
+    const auto valuesOf = [](const std::unordered_map<size_t, std::vector<std::string>> &hash, size_t offset)
+            -> const std::vector<std::string> & {
+        const auto it = hash.find(offset);
+        return it == hash.cend() ? noValues : it->second;
+    };
+    const auto countOf = [](const std::unordered_map<size_t, uint32_t> &counts, size_t offset) -> uint32_t {
+        const auto it = counts.find(offset);
+        return it == counts.cend() ? 0 : it->second;
+    };
+
+    std::vector<size_t> changedOptions;
+    for (size_t word = 0; word < foundOptions.size(); ++word) {
+        const uint64_t before = word < previousFound.size() ? previousFound[word] : 0;
+        uint64_t candidates = before | foundOptions[word];
+        for (size_t bit = 0; candidates; ++bit, candidates >>= 1) {
+            if (!(candidates & 1))
+                continue;
+            const size_t offset = word * 64 + bit;
+            if (((before ^ foundOptions[word]) >> bit) & 1
+                    || countOf(previousCounts, offset) != countOf(occurrenceCounts, offset)
+                    || valuesOf(previousValues, offset) != valuesOf(optionValuesHash, offset))
+                changedOptions.push_back(offset);
+        }
+    }
+
+    // Handlers run once the new state is complete, so they may query the parser.
+    for (size_t offset : changedOptions) {
+        const auto it = optionChangeHandlers.find(offset);
+        if (it != optionChangeHandlers.cend())
+            it->second(option(offset));
+    }
+    if (positionalArgumentsChangeHandler && previousPositionals != positionalArgumentList)
+        positionalArgumentsChangeHandler();
+    return true;
+}
+
+// Returns true if \a a and \a b define the same options at every offset both
+// have, so that rows parsed with either fit the same table columns.
+static bool sameColumns(const OptionTable *a, const OptionTable *b)
+{
+    if (a->size() > b->size())
+        std::swap(a, b);
+    for (const OptionTable *table = b; table; table = table->base.get()) {
+        if (table == a)
+            return true; // b was stacked on a
+    }
+    // Layers are merged as options are added, so equal columns may still
+    // come from different layers.
+    for (size_t offset = 0; offset < a->size(); ++offset) {
+        if (a->at(offset).names() != b->at(offset).names())
+            return false;
+    }
+    return true;
+}
+
+/*!
+    Parses \a arguments like parse() and appends the result to \a table as
+    a new row, also when parsing fails. Returns true if parsing succeeded.
+
+    The parser's own result is updated as well, so a row can still be
+    inspected through the usual accessors. Values are stored as given, so
+    an \c{@path} value is stored as the reference rather than the contents
+    of the file, and defaults are not filled in. A table
+    should be filled by one parser, or by overlays of one parser. If the
+    options of this parser disagree with the columns of \a table, for
+    example because it is an overlay adding other options than the overlay
+    that filled the table, a warning is printed, nothing is parsed and false
+    is returned.
+
+    \sa QCommandLineTable
+*/
+bool QCommandLineParser::parseIntoTable(QCommandLineTable *table, const std::vector<std::string> &arguments)
+{
+    QCommandLineTablePrivate *td = table->d;
+    std::shared_ptr<const OptionTable> optionTable = d->shareOptionTable();
+    if (td->optionTable && td->optionTable != optionTable) {
+        if (!sameColumns(td->optionTable.get(), optionTable.get())) {
+            qCommandLineWarning({"QCommandLineParser: the options of the parser do not match the columns of the table"});
+            return false;
+        }
+        if (td->optionTable->size() > optionTable->size())
+            optionTable = td->optionTable; // keep the names of all columns
+    }
+
+    const bool result = d->parse(arguments);
+    const size_t row = td->rowCount;
+
+    td->optionTable = std::move(optionTable);
+    td->addColumns(d->optionCount());
+    // only the columns of the options found take space in this row
+    for (const auto &found : d->occurrenceCounts) {
+        QCommandLineTable::Column &column = td->columns[found.first];
+        QCommandLineTablePrivate::setPresent(&column, row);
+        const auto it = d->optionValuesHash.find(found.first);
+        if (it != d->optionValuesHash.cend())
+            QCommandLineTablePrivate::appendValues(&column, it->second);
+        else
+            column.rowOffsets.push_back(column.valueOffsets.size() - 1);
+    }
+    QCommandLineTablePrivate::appendValues(&td->positionalColumn, d->positionalArgumentList);
+
+    QCommandLineTable::ErrorColumn &errorColumn = td->errorColumn;
+    for (const ParseError &error : d->errors) {
+        errorColumn.kinds.push_back(static_cast<uint8_t>(error.kind));
+        errorColumn.columns.push_back(error.optionOffset == std::string::npos
+                                      ? UINT32_MAX : static_cast<uint32_t>(error.optionOffset));
+    }
+    errorColumn.rowOffsets.push_back(errorColumn.kinds.size());
+    ++td->rowCount;
+    return result;
+}
+
 bool QCommandLineParser::isSet(const std::string &name) const
 {
     d->checkParsed("isSet");
-    auto result1 = std::find(d->optionNames.begin(), d->optionNames.end(), name);
-    if (result1 != d->optionNames.end())
-        return true;
-    const std::vector<std::string> aliases = d->aliases(name);
-    for (const std::string &optionName : static_cast<const std::vector<std::string>&>(d->optionNames)) {
-        auto result2 = std::find(aliases.begin(), aliases.end(), optionName);
-        if (result2 != aliases.end())
-            return true;
+    const size_t optionOffset = d->findOption(name);
+    if (optionOffset == std::string::npos) {
+        qCommandLineWarning({"QCommandLineParser: option not defined: \"", name, "\""});
+        return false;
     }
-    return false;
+    return testBit(d->foundOptions, optionOffset);
+}
+
+/*!
+    Returns how often the option \a name, under any of its names, was
+    found by the last parse. Unlike counting values() or optionNames(), this
+    works with every occurrence policy and takes constant time.
+
+    \sa QCommandLineOption::setOccurrencePolicy()
+*/
+size_t QCommandLineParser::occurrenceCount(const std::string &name) const
+{
+    d->checkParsed("occurrenceCount");
+    const size_t optionOffset = d->findOption(name);
+    if (optionOffset == std::string::npos) {
+        qCommandLineWarning({"QCommandLineParser: option not defined: \"", name, "\""});
+        return 0;
+    }
+    const auto it = d->occurrenceCounts.find(optionOffset);
+    return it == d->occurrenceCounts.cend() ? 0 : it->second;
 }
 
 std::string QCommandLineParser::value(const std::string &optionName) const
 {
     d->checkParsed("value");
-    const std::vector<std::string> valueList = values(optionName);
+    const size_t optionOffset = d->findOption(optionName);
+    if (optionOffset == std::string::npos) {
+        qCommandLineWarning({"QCommandLineParser: option not defined: \"", optionName, "\""});
+        return std::string();
+    }
 
-    if (!valueList.empty())
-        return valueList.back();
+    // Only the last value is needed, so the value list is not copied
+    const auto it = d->optionValuesHash.find(optionOffset);
+    if (it != d->optionValuesHash.cend() && !it->second.empty())
+        return std::string(d->resolveValue(optionOffset, it->second.back()));
+    const std::vector<std::string> defaultValues = d->option(optionOffset).defaultValues();
+    if (!defaultValues.empty())
+        return std::string(d->resolveValue(optionOffset, defaultValues.back()));
 
     return std::string();
 }
@@ -489,22 +1914,71 @@ std::string QCommandLineParser::value(const std::string &optionName) const
 std::vector<std::string> QCommandLineParser::values(const std::string &optionName) const
 {
     d->checkParsed("values");
-    const NameHash_t::const_iterator it = d->nameHash.find(optionName);
-    if (it != d->nameHash.cend()) {
-        const size_t optionOffset = (*it).second;
+    const size_t optionOffset = d->findOption(optionName);
+    if (optionOffset != std::string::npos) {
         std::vector<std::string> values;
         auto it = d->optionValuesHash.find(optionOffset);
         if (it != d->optionValuesHash.cend())
             values = it->second;
         if (values.empty())
-            values = d->commandLineOptionList.at(optionOffset).defaultValues();
+            values = d->option(optionOffset).defaultValues();
+        if (d->readsValueFiles(optionOffset)) {
+            for (std::string &value : values)
+                value = std::string(d->resolveValue(optionOffset, value));
+        }
         return values;
     }
 
-    std::cerr << "QCommandLineParser: option not defined: \"" << optionName << "\"" << std::endl;
+    qCommandLineWarning({"QCommandLineParser: option not defined: \"", optionName, "\""});
     return std::vector<std::string>();
 }
 
+/*!
+    Returns a view of the last value found for the option \a optionName, or
+    of its last default value, without copying it. An \c{@path} value of an
+    option that allows values from files is the mapped contents of the file.
+
+    The view stays valid until the parser is parsed again or destroyed. Use
+    snapshot() to keep values around longer.
+
+    \sa value(), valueViews(), QCommandLineOption::setValueFromFileAllowed()
+*/
+std::string_view QCommandLineParser::valueView(const std::string &optionName) const
+{
+    d->checkParsed("valueView");
+    const size_t optionOffset = d->findOption(optionName);
+    const std::vector<std::string> *valueList = d->valueList(optionOffset);
+    if (!valueList) {
+        qCommandLineWarning({"QCommandLineParser: option not defined: \"", optionName, "\""});
+        return std::string_view();
+    }
+    if (valueList->empty())
+        return std::string_view();
+    return d->resolveValue(optionOffset, valueList->back());
+}
+
+/*!
+    Returns views of all values found for the option \a optionName, or of
+    its default values, under the same rules and lifetime as valueView().
+
+    \sa values()
+*/
+std::vector<std::string_view> QCommandLineParser::valueViews(const std::string &optionName) const
+{
+    d->checkParsed("valueViews");
+    const size_t optionOffset = d->findOption(optionName);
+    const std::vector<std::string> *valueList = d->valueList(optionOffset);
+    if (!valueList) {
+        qCommandLineWarning({"QCommandLineParser: option not defined: \"", optionName, "\""});
+        return std::vector<std::string_view>();
+    }
+    std::vector<std::string_view> views;
+    views.reserve(valueList->size());
+    for (const std::string &value : *valueList)
+        views.push_back(d->resolveValue(optionOffset, value));
+    return views;
+}
+
 bool QCommandLineParser::isSet(const QCommandLineOption &option) const
 {
     // option.names() might be empty if the constructor failed
@@ -522,6 +1996,21 @@ std::vector<std::string> QCommandLineParser::values(const QCommandLineOption &op
     return values(option.names().front());
 }
 
+size_t QCommandLineParser::occurrenceCount(const QCommandLineOption &option) const
+{
+    return occurrenceCount(option.names().front());
+}
+
+std::string_view QCommandLineParser::valueView(const QCommandLineOption &option) const
+{
+    return valueView(option.names().front());
+}
+
+std::vector<std::string_view> QCommandLineParser::valueViews(const QCommandLineOption &option) const
+{
+    return valueViews(option.names().front());
+}
+
 std::vector<std::string> QCommandLineParser::positionalArguments() const
 {
     d->checkParsed("positionalArguments");
@@ -540,6 +2029,120 @@ std::vector<std::string> QCommandLineParser::unknownOptionNames() const
     return d->unknownOptionNames;
 }
 
+/*!
+    Returns an immutable copy of the result of the last parse.
+
+    Unlike the parser, a snapshot can be read from any number of threads
+    while the parser goes on to parse or reparse() other arguments. Values
+    are views into a single buffer owned by the snapshot, or into the string
+    pool if one was set. Snapshots share the option table with the parser
+    and view the default values in it, so taking one costs as much as the
+    options and arguments given, however many options are defined. Publish
+    snapshots to reader threads with QCommandLineSnapshotPublisher.
+
+    \sa setStringPool()
+*/
+std::shared_ptr<const QCommandLineSnapshot> QCommandLineParser::snapshot() const
+{
+    d->checkParsed("snapshot");
+
+    QCommandLineSnapshotPrivate *dd = new QCommandLineSnapshotPrivate;
+    dd->optionTable = d->shareOptionTable();
+
+    // The found options, and those whose defaults name value files, which
+    // the table cannot view in place.
+    std::vector<size_t> offsets;
+    offsets.reserve(d->occurrenceCounts.size());
+    for (const auto &found : d->occurrenceCounts)
+        offsets.push_back(found.first);
+    for (const OptionTable *table = dd->optionTable.get(); table; table = table->base.get()) {
+        const std::vector<size_t> &fileDefaults = table->layerDefaults()->fileDefaults;
+        offsets.insert(offsets.end(), fileDefaults.cbegin(), fileDefaults.cend());
+    }
+    std::sort(offsets.begin(), offsets.end());
+    offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+
+    std::vector<const std::vector<std::string> *> valueLists(offsets.size());
+    size_t storageSize = 0;
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        valueLists[i] = d->valueList(offsets.at(i));
+        for (const std::string &value : *valueLists[i])
+            storageSize += value.size();
+    }
+    for (const std::string &argument : d->positionalArgumentList)
+        storageSize += argument.size();
+
+    QCommandLineStringPool *pool = d->stringPool.get();
+    if (!pool)
+        dd->storage.reserve(storageSize); // views below stay valid as long as nothing reallocates
+    const auto store = [dd, pool](std::string_view text) {
+        if (pool) {
+            std::shared_ptr<const void> owner;
+            const std::string_view pooled = pool->intern(text, &owner);
+            // a concurrent trim() may move later strings to a new generation
+            if (dd->pooledStrings.empty() || dd->pooledStrings.back() != owner)
+                dd->pooledStrings.push_back(std::move(owner));
+            return pooled;
+        }
+        const size_t position = dd->storage.size();
+        dd->storage.append(text);
+        return std::string_view(dd->storage.data() + position, text.size());
+    };
+    dd->entries.resize(offsets.size());
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        const size_t offset = offsets.at(i);
+        QCommandLineSnapshotPrivate::Entry &entry = dd->entries[i];
+        entry.offset = offset;
+        entry.isSet = testBit(d->foundOptions, offset);
+        entry.values.reserve(valueLists[i]->size());
+        const bool valueFromFileAllowed = d->readsValueFiles(offset);
+        for (const std::string &value : *valueLists[i]) {
+            std::shared_ptr<const void> mappedFile;
+            const std::string_view resolved = valueFromFileAllowed ? d->resolveValue(offset, value, &mappedFile)
+                                                                   : std::string_view(value);
+            if (mappedFile) {
+                // File contents are shared with the mapping rather than copied.
+                dd->mappedFiles.push_back(mappedFile);
+                entry.values.push_back(resolved);
+            } else {
+                entry.values.push_back(store(resolved));
+            }
+        }
+    }
+    dd->positionalArguments.reserve(d->positionalArgumentList.size());
+    for (const std::string &argument : d->positionalArgumentList)
+        dd->positionalArguments.push_back(store(argument));
+
+    return std::shared_ptr<const QCommandLineSnapshot>(new QCommandLineSnapshot(dd));
+}
+
+/*!
+    Makes snapshots store their values and positional arguments in \a pool,
+    which keeps each distinct string once however many snapshots contain it.
+    This greatly reduces the memory taken by many retained results of
+    similar command lines, such as job specifications, and equal values of
+    such snapshots can be compared by their data pointer.
+
+    The pool may be shared with other parsers, including parsers on other
+    threads. Snapshots keep the strings they use alive, also past
+    QCommandLineStringPool::trim() and the destruction of the pool. Pass
+    \c nullptr to give each snapshot its own buffer again.
+
+    \sa snapshot(), QCommandLineStringPool::intern(), QCommandLineStringPool::trim()
+*/
+void QCommandLineParser::setStringPool(const std::shared_ptr<QCommandLineStringPool> &pool)
+{
+    d->stringPool = pool;
+}
+
+/*!
+    Returns the string pool used by snapshots, or \c nullptr.
+*/
+std::shared_ptr<QCommandLineStringPool> QCommandLineParser::stringPool() const
+{
+    return d->stringPool;
+}
+
 void QCommandLineParser::showVersion()
 {
     ::exit(EXIT_SUCCESS);
@@ -561,111 +2164,340 @@ std::string QCommandLineParser::helpText() const
     return d->helpText();
 }
 
-static std::string wrapText(const std::string &names, size_t longestOptionNameString, const std::string &description)
+/*!
+    Returns the help for the options of \a group only: its heading followed
+    by its options, laid out exactly as in the full helpText(). Pass an empty
+    \a group for the options not in any group.
+
+    Descriptions are only computed for the options of that group, which keeps
+    rendering one section of a very large option table cheap.
+
+    \sa optionGroups(), QCommandLineOption::setGroup()
+*/
+std::string QCommandLineParser::helpText(const std::string &group) const
+{
+    return d->groupHelpText(group);
+}
+
+/*!
+    Returns the names of the option groups, in the order in which the help
+    text lists them.
+*/
+std::vector<std::string> QCommandLineParser::optionGroups() const
+{
+    std::vector<std::string> groups;
+    for (const auto &section : d->helpSections()) {
+        if (!section.first.empty())
+            groups.push_back(section.first);
+    }
+    return groups;
+}
+
+// Returns the length of the run of ASCII bytes at the start of \a data.
+static size_t asciiRunLength(const char *data, size_t size)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= size; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const int nonAscii = _mm_movemask_epi8(chunk);
+        if (nonAscii)
+            return i + __builtin_ctz(nonAscii);
+    }
+#endif
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        if (word & UINT64_C(0x8080808080808080))
+            break;
+    }
+    while (i < size && !(data[i] & 0x80))
+        ++i;
+    return i;
+}
+
+// Decodes the UTF-8 sequence at \a data into a code point and returns its
+// length in bytes. Invalid or truncated sequences decode to one byte each.
+static size_t decodeUtf8(const unsigned char *data, size_t size, uint32_t *codePoint)
+{
+    const unsigned char lead = data[0];
+    size_t length;
+    uint32_t result;
+    if (lead < 0x80) {
+        *codePoint = lead;
+        return 1;
+    } else if (lead >= 0xc2 && lead < 0xe0) {
+        length = 2;
+        result = lead & 0x1f;
+    } else if (lead >= 0xe0 && lead < 0xf0) {
+        length = 3;
+        result = lead & 0x0f;
+    } else if (lead >= 0xf0 && lead < 0xf5) {
+        length = 4;
+        result = lead & 0x07;
+    } else {
+        *codePoint = 0xfffd;
+        return 1;
+    }
+    if (length > size) {
+        *codePoint = 0xfffd;
+        return 1;
+    }
+    for (size_t i = 1; i < length; ++i) {
+        if ((data[i] & 0xc0) != 0x80) {
+            *codePoint = 0xfffd;
+            return 1;
+        }
+        result = (result << 6) | (data[i] & 0x3f);
+    }
+    *codePoint = result;
+    return length;
+}
+
+// Returns the number of terminal columns taken by \a codePoint: 0 for
+// combining marks and zero-width characters, 2 for East Asian wide and
+// fullwidth characters, 1 otherwise.
+static size_t codePointWidth(uint32_t codePoint)
+{
+    static const uint32_t zeroWidth[][2] = {
+        { 0x0300, 0x036f }, { 0x0483, 0x0489 }, { 0x0591, 0x05bd }, { 0x0610, 0x061a },
+        { 0x064b, 0x065f }, { 0x200b, 0x200f }, { 0x20d0, 0x20ff }, { 0xfe00, 0xfe0f },
+        { 0xfe20, 0xfe2f }
+    };
+    static const uint32_t wide[][2] = {
+        { 0x1100, 0x115f }, { 0x2e80, 0x303e }, { 0x3041, 0x33ff }, { 0x3400, 0x4dbf },
+        { 0x4e00, 0x9fff }, { 0xa000, 0xa4cf }, { 0xac00, 0xd7a3 }, { 0xf900, 0xfaff },
+        { 0xfe30, 0xfe4f }, { 0xff00, 0xff60 }, { 0xffe0, 0xffe6 }, { 0x1f300, 0x1f64f },
+        { 0x1f900, 0x1f9ff }, { 0x20000, 0x2fffd }, { 0x30000, 0x3fffd }
+    };
+    if (codePoint < 0x0300)
+        return 1;
+    for (const auto &range : zeroWidth) {
+        if (codePoint >= range[0] && codePoint <= range[1])
+            return 0;
+    }
+    for (const auto &range : wide) {
+        if (codePoint >= range[0] && codePoint <= range[1])
+            return 2;
+    }
+    return 1;
+}
+
+static size_t displayWidth(const std::string &text)
+{
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(text.data());
+    size_t width = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        const size_t ascii = asciiRunLength(text.data() + i, text.size() - i);
+        width += ascii;
+        i += ascii;
+        if (i < text.size()) {
+            uint32_t codePoint;
+            i += decodeUtf8(data + i, text.size() - i, &codePoint);
+            width += codePointWidth(codePoint);
+        }
+    }
+    return width;
+}
+
+static std::string wrapText(const std::string &names, size_t nameColumnWidth, const std::string &description)
 {
     const char nl('\n');
-    std::ostringstream oss;
-    oss << std::setw(longestOptionNameString) << std::left << names;
-    std::string text = std::string("  ") + oss.str() + char(' ');
-    const int indent = text.length();
-    int lineStart = 0;
-    int lastBreakable = -1;
-    const int max = 79 - indent;
-    int x = 0;
-    const int len = description.length();
-
-    for (int i = 0; i < len; ++i) {
-        ++x;
-        const char c = description.at(i);
-        if (isspace(c))
-            lastBreakable = i;
-
-        int breakAt = -1;
-        int nextLineStart = -1;
-        if (x > max && lastBreakable != -1) {
-            // time to break and we know where
-            breakAt = lastBreakable;
-            nextLineStart = lastBreakable + 1;
-        } else if ((x > max - 1 && lastBreakable == -1) || i == len - 1) {
-            // time to break but found nowhere [-> break here], or end of last line
-            breakAt = i + 1;
-            nextLineStart = breakAt;
-        } else if (c == nl) {
-            // forced break
-            breakAt = i;
-            nextLineStart = i + 1;
-        }
-
-        if (breakAt != -1) {
-            const int numChars = breakAt - lineStart;
-            //qDebug() << "breakAt=" << description.at(breakAt) << "breakAtSpace=" << breakAtSpace << lineStart << "to" << breakAt << description.mid(lineStart, numChars);
-            if (lineStart > 0)
-                text += std::string(indent, ' ');
-            text += description.substr(lineStart, numChars) + nl;
-            x = 0;
-            lastBreakable = -1;
-            lineStart = nextLineStart;
-            if (lineStart < len && isspace(description.at(lineStart)))
-                ++lineStart; // don't start a line with a space
-            i = lineStart;
+    const size_t nameWidth = displayWidth(names);
+    std::string text = std::string("  ") + names
+            + std::string(nameColumnWidth > nameWidth ? nameColumnWidth - nameWidth : 0, ' ') + ' ';
+    const size_t indent = nameColumnWidth + 3;
+    const size_t max = indent < 79 ? 79 - indent : 1;
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(description.data());
+    const size_t len = description.length();
+
+    if (len == 0)
+        return text + nl;
+
+    size_t lineStart = 0;
+    while (lineStart < len) {
+        // Find where the line starting at lineStart ends, measuring columns
+        // rather than bytes. An ASCII run takes one column per byte, so as
+        // much of it as fits is measured at once and only searched for a
+        // newline; code points are only decoded outside ASCII runs.
+        size_t lineEnd = len;
+        size_t nextLineStart = len;
+        size_t x = 0;
+        size_t i = lineStart;
+        bool full = false;
+        while (i < len) {
+            if (data[i] < 0x80) {
+                if (data[i] == nl) {
+                    // forced break
+                    lineEnd = i;
+                    nextLineStart = i + 1;
+                    break;
+                }
+                if (x >= max) {
+                    full = true;
+                    break;
+                }
+                const size_t run = asciiRunLength(description.data() + i, std::min(len - i, max - x));
+                const void *newline = memchr(data + i, nl, run);
+                if (newline) {
+                    lineEnd = static_cast<const unsigned char *>(newline) - data;
+                    nextLineStart = lineEnd + 1;
+                    break;
+                }
+                x += run;
+                i += run;
+            } else {
+                uint32_t codePoint;
+                const size_t charLength = decodeUtf8(data + i, len - i, &codePoint);
+                const size_t charWidth = codePointWidth(codePoint);
+                if (x + charWidth > max && i > lineStart) {
+                    full = true;
+                    break;
+                }
+                x += charWidth;
+                i += charLength;
+            }
         }
+        if (full) {
+            // Break after the last space on the line, or here if there is
+            // none. Multi-byte sequences never contain ASCII bytes.
+            lineEnd = i;
+            nextLineStart = i;
+            for (size_t j = i; j-- > lineStart; ) {
+                if (isspace(data[j])) {
+                    lineEnd = j;
+                    nextLineStart = j + 1;
+                    break;
+                }
+            }
+        }
+
+        if (lineStart > 0)
+            text += std::string(indent, ' ');
+        text.append(description, lineStart, lineEnd - lineStart);
+        text += nl;
+        lineStart = nextLineStart;
+        if (lineStart < len && description.at(lineStart) == ' ')
+            ++lineStart; // don't start a line with a space
     }
 
     return text;
 }
 
+static std::string optionNamesString(const QCommandLineOption &option)
+{
+    const std::vector<std::string> optionNames = option.names();
+    std::string optionNamesString;
+    for (const std::string &optionName : optionNames)
+        optionNamesString += dashedOptionName(optionName) + std::string(", ");
+    if (!optionNames.empty()) {
+        optionNamesString.pop_back();
+        optionNamesString.pop_back();
+    }
+    const auto valueName = option.valueName();
+    if (!valueName.empty())
+        optionNamesString += std::string(" <") + valueName + std::string(">");
+    return optionNamesString;
+}
+
+// Returns the offsets of the visible options by help section: options without
+// a group first, then each group in the order in which it first appears.
+std::vector<std::pair<std::string, std::vector<size_t>>> QCommandLineParserPrivate::helpSections() const
+{
+    std::vector<std::pair<std::string, std::vector<size_t>>> sections(1);
+    std::unordered_map<std::string, size_t> sectionIndex;
+    for (size_t offset = 0; offset < optionCount(); ++offset) {
+        const QCommandLineOption &option = optionTable->at(offset);
+        if (option.isHidden())
+            continue;
+        const std::string group = option.group();
+        size_t index = 0;
+        if (!group.empty()) {
+            const auto it = sectionIndex.insert({group, sections.size()}).first;
+            if (it->second == sections.size())
+                sections.emplace_back(group, std::vector<size_t>());
+            index = it->second;
+        }
+        sections[index].second.push_back(offset);
+    }
+    return sections;
+}
+
+// Returns the names of the options listed in \a sections by offset, and
+// stores the width of the name column in \a nameColumnWidth. The column is
+// as wide for the help of one group as for the full help.
+std::vector<std::string> QCommandLineParserPrivate::helpOptionNames(
+        const std::vector<std::pair<std::string, std::vector<size_t>>> &sections, size_t *nameColumnWidth) const
+{
+    std::vector<std::string> optionNameList(optionCount());
+    size_t longestOptionNameString = 0;
+    for (const auto &section : sections) {
+        for (size_t offset : section.second) {
+            optionNameList[offset] = optionNamesString(optionTable->at(offset));
+            longestOptionNameString = std::max(longestOptionNameString, displayWidth(optionNameList[offset]));
+        }
+    }
+    *nameColumnWidth = longestOptionNameString + 1;
+    return optionNameList;
+}
+
 std::string QCommandLineParserPrivate::helpText() const
 {
-const char nl('\n');
-std::string text;
-std::string usage;
-usage += std::string("[executable name]");
-if (!commandLineOptionList.empty())
-usage += std::string(" ") + "[options]";
-for (const PositionalArgumentDefinition &arg : positionalArgumentDefinitions)
-usage += std::string(" ") + arg.syntax;
-text += "Usage: " + usage + nl;
-if (!description.empty())
-text += description + nl;
-text += nl;
-if (!commandLineOptionList.empty())
-text += std::string("Options:") + nl;
-std::vector<std::string> optionNameList;
-optionNameList.reserve(commandLineOptionList.size());
-size_t longestOptionNameString = 0;
-for (const QCommandLineOption &option : commandLineOptionList) {
-if (option.isHidden())
- continue;
-const std::vector<std::string> optionNames = option.names();
-std::string optionNamesString;
-for (const std::string &optionName : optionNames) {
-const size_t numDashes = optionName.length() == 1 ? 1 : 2;
-optionNamesString += std::string("--", numDashes) + optionName + std::string(", ");
-}
-if (!optionNames.empty()) {
-optionNamesString.pop_back();
- optionNamesString.pop_back();
-}
-const auto valueName = option.valueName();
-if (!valueName.empty())
-optionNamesString += std::string(" <") + valueName + std::string(">");
- optionNameList.push_back(optionNamesString);
-longestOptionNameString = std::max(longestOptionNameString, optionNamesString.length());
-}
-++longestOptionNameString;
-auto optionNameIterator = optionNameList.cbegin();
-for (const QCommandLineOption &option : commandLineOptionList) {
- if (option.isHidden())
-continue;
-text += wrapText(*optionNameIterator, longestOptionNameString, option.description());
-++optionNameIterator;
-}
-if (!positionalArgumentDefinitions.empty()) {
-if (!commandLineOptionList.empty())
-text += nl;
-text += std::string("Arguments:") + nl;
-for (const PositionalArgumentDefinition &arg : positionalArgumentDefinitions)
-text += wrapText(arg.name, longestOptionNameString, arg.description);
-}
-return text;
+    const char nl('\n');
+    std::string text;
+    std::string usage;
+    usage += std::string("[executable name]");
+    if (optionCount() > 0)
+        usage += std::string(" ") + "[options]";
+    for (const PositionalArgumentDefinition &arg : positionalArgumentDefinitions)
+        usage += std::string(" ") + arg.syntax;
+    text += "Usage: " + usage + nl;
+    if (!description.empty())
+        text += description + nl;
+    text += nl;
+
+    const std::vector<std::pair<std::string, std::vector<size_t>>> sections = helpSections();
+    size_t longestOptionNameString;
+    const std::vector<std::string> optionNameList = helpOptionNames(sections, &longestOptionNameString);
+
+    bool firstSection = true;
+    for (const auto &section : sections) {
+        if (section.second.empty())
+            continue;
+        if (!firstSection)
+            text += nl;
+        firstSection = false;
+        text += (section.first.empty() ? std::string("Options") : section.first) + ":" + nl;
+        for (size_t offset : section.second)
+            text += wrapText(optionNameList[offset], longestOptionNameString, optionTable->at(offset).description());
+    }
+    if (!positionalArgumentDefinitions.empty()) {
+        if (!firstSection)
+            text += nl;
+        text += std::string("Arguments:") + nl;
+        for (const PositionalArgumentDefinition &arg : positionalArgumentDefinitions)
+            text += wrapText(arg.name, longestOptionNameString, arg.description);
+    }
+    return text;
+}
+
+std::string QCommandLineParserPrivate::groupHelpText(const std::string &group) const
+{
+    const std::vector<std::pair<std::string, std::vector<size_t>>> sections = helpSections();
+    const std::vector<size_t> *offsets = nullptr;
+    for (const auto &section : sections) {
+        if (section.first == group)
+            offsets = &section.second;
+    }
+    if (!offsets || offsets->empty())
+        return std::string();
+
+    size_t longestOptionNameString;
+    const std::vector<std::string> optionNameList = helpOptionNames(sections, &longestOptionNameString);
+
+    std::string text = (group.empty() ? std::string("Options") : group) + ":\n";
+    for (size_t offset : *offsets)
+        text += wrapText(optionNameList[offset], longestOptionNameString, optionTable->at(offset).description());
+    return text;
 }
@@ -45,9 +45,15 @@
 //#include "qcoreapplication.h"
 #include "qcommandlineoption.h"
 
+#include <functional>
+#include <string_view>
+
 //QT_BEGIN_NAMESPACE
 
 class QCommandLineParserPrivate;
+class QCommandLineSnapshot;
+class QCommandLineStringPool;
+class QCommandLineTable;
 //class QCoreApplication;
 
 class QCommandLineParser
@@ -57,6 +63,8 @@ public:
     QCommandLineParser();
     ~QCommandLineParser();
 
+    std::unique_ptr<QCommandLineParser> createOverlay() const;
+
     enum SingleDashWordOptionMode {
         ParseAsCompactedShortOptions,
         ParseAsLongOptions
@@ -69,8 +77,30 @@ public:
     };
     void setOptionsAfterPositionalArgumentsMode(OptionsAfterPositionalArgumentsMode mode);
 
+    enum LongOptionMatchingMode {
+        MatchExactLongOptions,
+        MatchUniqueLongOptionPrefixes
+    };
+    void setLongOptionMatchingMode(LongOptionMatchingMode mode);
+
+    enum PositionalArgumentExpansionMode {
+        KeepPositionalArguments,
+        ExpandGlobPatterns
+    };
+    void setPositionalArgumentExpansionMode(PositionalArgumentExpansionMode mode);
+    typedef std::function<void(const std::string &path)> GlobMatchHandler;
+    void setGlobMatchHandler(const GlobMatchHandler &handler);
+
+    enum ValueFileMode {
+        ReadValueFilesOnFirstUse,
+        ReadValueFilesWhileParsing,
+        IgnoreValueFiles
+    };
+    void setValueFileMode(ValueFileMode mode);
+
     bool addOption(const QCommandLineOption &commandLineOption);
     bool addOptions(const std::vector<QCommandLineOption> &options);
+    bool addMutuallyExclusiveOptions(const std::vector<std::string> &names);
 
     QCommandLineOption addVersionOption();
     QCommandLineOption addHelpOption();
@@ -86,21 +116,72 @@ public:
     bool parse(const std::vector<std::string> &arguments);
     std::string errorText() const;
 
+    enum ParseErrorKind {
+        UnknownOption,
+        AmbiguousOption,
+        MissingValue,
+        UnexpectedValue,
+        MissingRequiredOption,
+        MissingDependency,
+        ConflictingOptions,
+        ValueOutOfRange,
+        InvalidValue,
+        RepeatedOption
+    };
+    struct ParseError
+    {
+        ParseErrorKind kind;
+        //! Index of the offending argument, the executable name being 0,
+        //! or std::string::npos for errors found after parsing.
+        size_t argumentIndex;
+        //! Byte range of the offending text within that argument.
+        size_t byteOffset;
+        size_t length;
+        //! Registration index of the option involved, or std::string::npos.
+        size_t optionOffset;
+        //! The other option of a MissingDependency or ConflictingOptions error,
+        //! the index of the value of a ValueOutOfRange or InvalidValue error,
+        //! or the errno value for a value file that could not be read.
+        size_t detail;
+    };
+    std::vector<ParseError> errors() const;
+    std::string errorText(const ParseError &error) const;
+
+    typedef std::function<void(const QCommandLineOption &option)> OptionChangeHandler;
+    void setOptionChangeHandler(const QCommandLineOption &option, const OptionChangeHandler &handler);
+    void setPositionalArgumentsChangeHandler(const std::function<void()> &handler);
+    bool reparse(const std::vector<std::string> &arguments);
+    bool parseIntoTable(QCommandLineTable *table, const std::vector<std::string> &arguments);
+
     bool isSet(const std::string &name) const;
     std::string value(const std::string &name) const;
     std::vector<std::string> values(const std::string &name) const;
+    size_t occurrenceCount(const std::string &name) const;
 
     bool isSet(const QCommandLineOption &option) const;
     std::string value(const QCommandLineOption &option) const;
     std::vector<std::string> values(const QCommandLineOption &option) const;
+    size_t occurrenceCount(const QCommandLineOption &option) const;
+
+    std::string_view valueView(const std::string &name) const;
+    std::vector<std::string_view> valueViews(const std::string &name) const;
+    std::string_view valueView(const QCommandLineOption &option) const;
+    std::vector<std::string_view> valueViews(const QCommandLineOption &option) const;
 
     std::vector<std::string> positionalArguments() const;
     std::vector<std::string> optionNames() const;
     std::vector<std::string> unknownOptionNames() const;
+    std::vector<std::string> suggestions(const std::string &unknownOptionName) const;
+
+    std::shared_ptr<const QCommandLineSnapshot> snapshot() const;
+    void setStringPool(const std::shared_ptr<QCommandLineStringPool> &pool);
+    std::shared_ptr<QCommandLineStringPool> stringPool() const;
 
     void showVersion();
     void showHelp(int exitCode = 0);
     std::string helpText() const;
+    std::string helpText(const std::string &group) const;
+    std::vector<std::string> optionGroups() const;
 
 private:
 //    Q_DISABLE_COPY(QCommandLineParser)
@@ -0,0 +1,894 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Copyright (C) 2013 David Faure <faure@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcommandlineserver.h"
+#include "qcommandlineparser.h"
+#include "qcommandlinediagnostics_p.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdlib.h>
+#include <thread>
+#include <unordered_map>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// A frame is a 32-bit little-endian payload length followed by the payload.
+// A request payload is the argument count followed by each argument; a reply
+// payload is the exit code, the output, the error count and each error text,
+// then the parse error count and each parse error as its kind followed by
+// its five 64-bit fields. Strings are a 32-bit length followed by the bytes.
+static const uint32_t MaximumFrameSize = 16 * 1024 * 1024;
+
+static void appendUint32(std::string *frame, uint32_t value)
+{
+    const char bytes[4] = { char(value), char(value >> 8), char(value >> 16), char(value >> 24) };
+    frame->append(bytes, 4);
+}
+
+static void appendUint64(std::string *frame, uint64_t value)
+{
+    appendUint32(frame, uint32_t(value));
+    appendUint32(frame, uint32_t(value >> 32));
+}
+
+static void appendString(std::string *frame, const std::string &text)
+{
+    appendUint32(frame, uint32_t(text.size()));
+    frame->append(text);
+}
+
+// The encoded size of a parse error: its kind and five 64-bit fields.
+static const size_t ParseErrorSize = 4 + 5 * 8;
+
+static void appendParseError(std::string *frame, const QCommandLineParser::ParseError &error)
+{
+    appendUint32(frame, uint32_t(error.kind));
+    appendUint64(frame, error.argumentIndex);
+    appendUint64(frame, error.byteOffset);
+    appendUint64(frame, error.length);
+    appendUint64(frame, error.optionOffset);
+    appendUint64(frame, error.detail);
+}
+
+// Starts \a frame with a placeholder for the payload length.
+static void beginFrame(std::string *frame)
+{
+    frame->assign(4, '\0');
+}
+
+static void endFrame(std::string *frame)
+{
+    const uint32_t size = uint32_t(frame->size() - 4);
+    for (int i = 0; i < 4; ++i)
+        (*frame)[i] = char(size >> (8 * i));
+}
+
+// Reads consecutive fields of a payload; ok turns false once it runs out.
+class PayloadReader
+{
+public:
+    explicit PayloadReader(const std::string &payload)
+        : payload(payload),
+          position(0),
+          ok(true)
+    { }
+
+    uint32_t readUint32()
+    {
+        if (payload.size() - position < 4) {
+            ok = false;
+            return 0;
+        }
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(payload.data()) + position;
+        position += 4;
+        return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+    }
+
+    uint64_t readUint64()
+    {
+        const uint64_t low = readUint32();
+        return low | uint64_t(readUint32()) << 32;
+    }
+
+    std::string readString()
+    {
+        const uint32_t size = readUint32();
+        if (!ok || payload.size() - position < size) {
+            ok = false;
+            return std::string();
+        }
+        position += size;
+        return payload.substr(position - size, size);
+    }
+
+    // Returns a count of items of at least \a itemSize bytes each, or 0 and
+    // fails if the payload is too short for that many, so that a bogus count
+    // never causes a huge allocation.
+    uint32_t readCount(size_t itemSize)
+    {
+        const uint32_t count = readUint32();
+        if (ok && count > (payload.size() - position) / itemSize)
+            ok = false;
+        return ok ? count : 0;
+    }
+
+    const std::string &payload;
+    size_t position;
+    bool ok;
+};
+
+#if !defined(_WIN32)
+#if defined(MSG_NOSIGNAL)
+static const int SendFlags = MSG_NOSIGNAL;
+#else
+static const int SendFlags = 0;
+#endif
+
+static bool readFully(int fd, char *data, size_t size)
+{
+    while (size > 0) {
+        const ssize_t count = ::read(fd, data, size);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return false;
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+static bool writeFully(int fd, const std::string &data)
+{
+    size_t position = 0;
+    while (position < data.size()) {
+        const ssize_t count = ::send(fd, data.data() + position, data.size() - position, SendFlags);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return false;
+        position += count;
+    }
+    return true;
+}
+
+static bool readFrame(int fd, std::string *payload)
+{
+    std::string header(4, '\0');
+    if (!readFully(fd, &header[0], header.size()))
+        return false;
+    const uint32_t size = PayloadReader(header).readUint32();
+    if (size > MaximumFrameSize)
+        return false;
+    payload->resize(size);
+    return readFully(fd, &(*payload)[0], size);
+}
+
+static bool setNonBlocking(int fd)
+{
+    const int flags = ::fcntl(fd, F_GETFL);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static bool socketAddress(const std::string &socketPath, sockaddr_un *address)
+{
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address->sun_path)) {
+        qCommandLineWarning({"QCommandLineServer: invalid socket path \"", socketPath, "\""});
+        return false;
+    }
+    memcpy(address->sun_path, socketPath.data(), socketPath.size());
+    return true;
+}
+#endif
+
+class QCommandLineServerPrivate
+{
+public:
+    //! A client connection, owned by the I/O thread.
+    struct Connection
+    {
+        Connection() : fd(-1), written(0), busy(false) { }
+
+        int fd;
+        //! Bytes received that do not form a complete request yet.
+        std::string input;
+        //! The reply being sent, and how much of it was sent.
+        std::string output;
+        size_t written;
+        //! Set while a worker handles a request of the connection, so that
+        //! its requests are handled one at a time and replied to in order.
+        bool busy;
+    };
+
+    //! A complete request, or the reply to it, of the connection with the given id.
+    struct Message
+    {
+        uint64_t connection;
+        std::string data;
+    };
+
+    explicit QCommandLineServerPrivate(const QCommandLineParser &schema)
+        : schema(schema.createOverlay()),
+          workerCount(std::max(std::thread::hardware_concurrency(), 1u)),
+          socketPermissions(0600),
+          clientFileAccessAllowed(false),
+          listenFd(-1),
+          nextConnection(0),
+          stopping(false)
+    {
+        wakeFds[0] = wakeFds[1] = -1;
+    }
+
+    void run();
+    void acceptConnections();
+    bool readConnection(Connection *connection);
+    bool writeConnection(Connection *connection);
+    bool takeRequest(uint64_t id, Connection *connection);
+    void wake();
+    void work(QCommandLineParser *parser);
+    std::string serve(QCommandLineParser *parser, const std::string &request) const;
+    QCommandLineServer::Reply dispatch(QCommandLineParser *parser, const std::vector<std::string> &arguments) const;
+
+    //! The option schema, frozen so that the workers' parsers share its options.
+    std::unique_ptr<QCommandLineParser> schema;
+
+    std::unordered_map<std::string, QCommandLineServer::Handler> handlers;
+    QCommandLineServer::Handler defaultHandler;
+    size_t workerCount;
+    unsigned int socketPermissions;
+    //! Whether clients may have their arguments read files or expand globs.
+    bool clientFileAccessAllowed;
+
+    std::string socketPath;
+    int listenFd;
+    //! Pipe by which workers and close() wake the I/O thread up from poll().
+    int wakeFds[2];
+    std::thread ioThread;
+    std::vector<std::thread> workers;
+    //! One overlay of the schema per worker, so parsing needs no locking.
+    std::vector<std::unique_ptr<QCommandLineParser>> parsers;
+
+    //! The connections by id, which unlike file descriptors are never
+    //! reused, so that a late reply cannot reach another client.
+    std::unordered_map<uint64_t, Connection> connections;
+    uint64_t nextConnection;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<Message> requests;
+    //! Replies for the I/O thread to send; an empty one drops its client.
+    std::vector<Message> replies;
+    bool stopping;
+};
+
+QCommandLineServer::Reply QCommandLineServerPrivate::dispatch(QCommandLineParser *parser,
+                                                              const std::vector<std::string> &arguments) const
+{
+    QCommandLineServer::Reply reply;
+    if (arguments.empty()) {
+        reply.exitCode = EXIT_FAILURE;
+        reply.errors.push_back("Empty argument list.");
+        return reply;
+    }
+    if (!parser->parse(arguments)) {
+        reply.exitCode = EXIT_FAILURE;
+        reply.parseErrors = parser->errors();
+        for (const QCommandLineParser::ParseError &error : reply.parseErrors)
+            reply.errors.push_back(parser->errorText(error));
+        return reply;
+    }
+    const auto it = handlers.find(arguments.front());
+    const QCommandLineServer::Handler &handler = it != handlers.cend() ? it->second : defaultHandler;
+    if (!handler) {
+        reply.exitCode = EXIT_FAILURE;
+        reply.errors.push_back("Unknown command: " + arguments.front());
+        return reply;
+    }
+    // An exception must not escape the worker thread, which would terminate the server
+    try {
+        return handler(*parser);
+    } catch (const std::exception &exception) {
+        reply.exitCode = EXIT_FAILURE;
+        reply.errors.push_back(std::string("Handler failed: ") + exception.what());
+    } catch (...) {
+        reply.exitCode = EXIT_FAILURE;
+        reply.errors.push_back("Handler failed.");
+    }
+    return reply;
+}
+
+// Returns the reply frame to the payload \a request, or an empty string if
+// the request is malformed and the client should be dropped.
+std::string QCommandLineServerPrivate::serve(QCommandLineParser *parser, const std::string &request) const
+{
+    std::vector<std::string> arguments;
+    PayloadReader reader(request);
+    arguments.resize(reader.readCount(4));
+    for (std::string &argument : arguments)
+        argument = reader.readString();
+    if (!reader.ok || reader.position != request.size())
+        return std::string();
+
+    const QCommandLineServer::Reply reply = dispatch(parser, arguments);
+    std::string frame;
+    beginFrame(&frame);
+    appendUint32(&frame, uint32_t(reply.exitCode));
+    appendString(&frame, reply.output);
+    appendUint32(&frame, uint32_t(reply.errors.size()));
+    for (const std::string &error : reply.errors)
+        appendString(&frame, error);
+    appendUint32(&frame, uint32_t(reply.parseErrors.size()));
+    for (const QCommandLineParser::ParseError &error : reply.parseErrors)
+        appendParseError(&frame, error);
+    endFrame(&frame);
+    return frame;
+}
+
+void QCommandLineServerPrivate::work(QCommandLineParser *parser)
+{
+    for (;;) {
+        Message request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return stopping || !requests.empty(); });
+            if (stopping)
+                return;
+            request = std::move(requests.front());
+            requests.pop_front();
+        }
+        Message reply = { request.connection, serve(parser, request.data) };
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            replies.push_back(std::move(reply));
+        }
+        wake();
+    }
+}
+
+void QCommandLineServerPrivate::wake()
+{
+#if !defined(_WIN32)
+    // A full pipe already holds a wake-up, so a failed write loses nothing.
+    const char byte = 0;
+    while (::write(wakeFds[1], &byte, 1) < 0 && errno == EINTR) {
+    }
+#endif
+}
+
+#if !defined(_WIN32)
+void QCommandLineServerPrivate::acceptConnections()
+{
+    for (;;) {
+        const int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                // Typically out of file descriptors; back off instead of spinning
+                qCommandLineWarning({"QCommandLineServer: accept failed: ", strerror(errno)});
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return;
+        }
+        if (!setNonBlocking(fd)) {
+            ::close(fd);
+            continue;
+        }
+        connections[nextConnection++].fd = fd;
+    }
+}
+
+// Returns false once the client closed the connection or it failed.
+bool QCommandLineServerPrivate::readConnection(Connection *connection)
+{
+    char buffer[64 * 1024];
+    for (;;) {
+        const ssize_t count = ::recv(connection->fd, buffer, sizeof(buffer), 0);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        if (count == 0)
+            return false;
+        connection->input.append(buffer, count);
+        return true;
+    }
+}
+
+// Sends as much of the pending reply as the socket takes without blocking.
+bool QCommandLineServerPrivate::writeConnection(Connection *connection)
+{
+    while (connection->written < connection->output.size()) {
+        const ssize_t count = ::send(connection->fd, connection->output.data() + connection->written,
+                                     connection->output.size() - connection->written, SendFlags);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return true;
+        if (count <= 0)
+            return false;
+        connection->written += count;
+    }
+    connection->output.clear();
+    connection->written = 0;
+    return true;
+}
+
+// Hands the next complete request of the connection with id \a id to the
+// workers, unless one is still being handled or replied to. Returns false
+// if the client announced an oversized frame.
+bool QCommandLineServerPrivate::takeRequest(uint64_t id, Connection *connection)
+{
+    if (connection->busy || !connection->output.empty() || connection->input.size() < 4)
+        return true;
+    const uint32_t size = PayloadReader(connection->input).readUint32();
+    if (size > MaximumFrameSize)
+        return false;
+    if (connection->input.size() - 4 < size)
+        return true;
+    Message request = { id, connection->input.substr(4, size) };
+    connection->input.erase(0, 4 + size);
+    connection->busy = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back(std::move(request));
+    }
+    condition.notify_one();
+    return true;
+}
+
+// The I/O thread: waits for all connections at once, so that idle clients
+// cost a file descriptor each but no thread.
+void QCommandLineServerPrivate::run()
+{
+    std::vector<pollfd> fds;
+    std::vector<uint64_t> ids;
+    std::vector<Message> finished;
+    for (;;) {
+        fds.clear();
+        ids.clear();
+        fds.push_back({ wakeFds[0], POLLIN, 0 });
+        fds.push_back({ listenFd, POLLIN, 0 });
+        for (const auto &entry : connections) {
+            const Connection &connection = entry.second;
+            short events = 0;
+            // no more input is read while a request is pending, which bounds the buffer
+            if (!connection.busy && connection.output.empty())
+                events |= POLLIN;
+            if (!connection.output.empty())
+                events |= POLLOUT;
+            fds.push_back({ connection.fd, events, 0 });
+            ids.push_back(entry.first);
+        }
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno != EINTR) {
+                qCommandLineWarning({"QCommandLineServer: poll failed: ", strerror(errno)});
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            continue;
+        }
+
+        if (fds[0].revents) {
+            char buffer[256];
+            while (::read(wakeFds[0], buffer, sizeof(buffer)) > 0) {
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (stopping)
+                    break;
+                finished.swap(replies);
+            }
+            for (Message &reply : finished) {
+                const auto it = connections.find(reply.connection);
+                if (it == connections.end())
+                    continue; // the client left while its request was handled
+                Connection &connection = it->second;
+                connection.busy = false;
+                connection.output = std::move(reply.data);
+                if (connection.output.empty() || !writeConnection(&connection)
+                        || !takeRequest(it->first, &connection)) {
+                    ::close(connection.fd);
+                    connections.erase(it);
+                }
+            }
+            finished.clear();
+        }
+        if (fds[1].revents)
+            acceptConnections();
+        for (size_t i = 2; i < fds.size(); ++i) {
+            if (!fds[i].revents)
+                continue;
+            const auto it = connections.find(ids[i - 2]);
+            if (it == connections.end())
+                continue;
+            Connection &connection = it->second;
+            bool ok = true;
+            if (fds[i].revents & POLLOUT)
+                ok = writeConnection(&connection);
+            if (ok && fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+                ok = readConnection(&connection);
+            if (!ok || !takeRequest(it->first, &connection)) {
+                ::close(connection.fd);
+                connections.erase(it);
+            }
+        }
+    }
+
+    for (const auto &entry : connections)
+        ::close(entry.second.fd);
+    connections.clear();
+}
+#else
+void QCommandLineServerPrivate::run()
+{
+}
+#endif
+
+/*!
+    Constructs a server that parses commands with the options and settings
+    of \a schema.
+
+    The server takes a frozen copy of the schema: every worker thread parses
+    with its own overlay of it, so all workers share one option table and
+    parse concurrently without locking. Options added to \a schema later are
+    not seen by the server.
+
+    Since clients may run with other privileges than the server, their
+    arguments never read value files or expand glob patterns, whatever the
+    modes of \a schema; see setClientFileAccessAllowed().
+
+    \sa QCommandLineParser::createOverlay()
+*/
+QCommandLineServer::QCommandLineServer(const QCommandLineParser &schema)
+    : d(new QCommandLineServerPrivate(schema))
+{
+}
+
+QCommandLineServer::~QCommandLineServer()
+{
+    close();
+    delete d;
+}
+
+/*!
+    Makes commands whose argument list starts with \a command, the name a
+    client would otherwise exec, call \a handler with the parser holding the
+    parsed arguments. The returned reply is sent back to the client.
+
+    Handlers run concurrently on the worker threads and are only called for
+    arguments that parsed without errors; parse errors are replied with
+    exit code EXIT_FAILURE and their texts. An exception thrown by a handler
+    is replied the same way, with a "Handler failed" error. Register
+    handlers before listen().
+*/
+void QCommandLineServer::setHandler(const std::string &command, const QCommandLineServer::Handler &handler)
+{
+    d->handlers[command] = handler;
+}
+
+/*!
+    Makes commands without a handler of their own call \a handler. Without
+    a default handler such commands fail with an "Unknown command" error.
+*/
+void QCommandLineServer::setDefaultHandler(const QCommandLineServer::Handler &handler)
+{
+    d->defaultHandler = handler;
+}
+
+/*!
+    Sets the number of worker threads, and so the number of requests
+    handled at the same time, to \a count. Defaults to the number of
+    hardware threads. Clients hold no worker between requests, so any number
+    of them may stay connected. Takes effect on the next listen().
+*/
+void QCommandLineServer::setWorkerCount(size_t count)
+{
+    d->workerCount = std::max<size_t>(count, 1);
+}
+
+/*!
+    Sets the file permissions of the socket, and so who may connect, to
+    \a permissions, such as 0660 to admit the group of the server. Defaults
+    to 0600, which admits only the user running the server. Takes effect
+    on the next listen().
+*/
+void QCommandLineServer::setSocketPermissions(unsigned int permissions)
+{
+    d->socketPermissions = permissions;
+}
+
+/*!
+    Sets whether the arguments of clients are parsed with the value file
+    and positional argument expansion modes of the schema to \a allowed.
+
+    By default they are not: \c{@path} values stay text and glob patterns
+    are kept as given, so that a client cannot make the server read files
+    it could not read itself. Only allow this when every client that can
+    connect is trusted with the files of the server. Takes effect on the
+    next listen().
+
+    \sa setSocketPermissions(), QCommandLineParser::setValueFileMode()
+*/
+void QCommandLineServer::setClientFileAccessAllowed(bool allowed)
+{
+    d->clientFileAccessAllowed = allowed;
+}
+
+/*!
+    Starts serving commands on a Unix domain socket bound to \a socketPath
+    and returns true on success. The socket file must not exist yet; it is
+    created with the permissions set by setSocketPermissions() and removed
+    again by close().
+
+    Each connection sends any number of requests and receives one reply per
+    request, in order. A request is a length-prefixed frame holding the
+    argument list, see QCommandLineClient::call(). One I/O thread waits for
+    all connections with poll() and hands each complete request to a free
+    worker, so an idle or slow client never ties up a worker.
+*/
+bool QCommandLineServer::listen(const std::string &socketPath)
+{
+#if !defined(_WIN32)
+    if (d->listenFd >= 0) {
+        qCommandLineWarning({"QCommandLineServer: already listening on \"", d->socketPath, "\""});
+        return false;
+    }
+    sockaddr_un address;
+    if (!socketAddress(socketPath, &address))
+        return false;
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        qCommandLineWarning({"QCommandLineServer: cannot create socket: ", strerror(errno)});
+        return false;
+    }
+    if (::bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+        qCommandLineWarning({"QCommandLineServer: cannot listen on \"", socketPath, "\": ", strerror(errno)});
+        ::close(fd);
+        return false;
+    }
+    // Connections are only accepted after listen(), so no client gets in
+    // under the permissions set by the umask.
+    if (::chmod(socketPath.c_str(), mode_t(d->socketPermissions)) != 0
+            || ::listen(fd, SOMAXCONN) != 0 || !setNonBlocking(fd)) {
+        qCommandLineWarning({"QCommandLineServer: cannot listen on \"", socketPath, "\": ", strerror(errno)});
+        ::close(fd);
+        ::unlink(socketPath.c_str());
+        return false;
+    }
+    if (::pipe(d->wakeFds) != 0 || !setNonBlocking(d->wakeFds[0]) || !setNonBlocking(d->wakeFds[1])) {
+        qCommandLineWarning({"QCommandLineServer: cannot create wake-up pipe: ", strerror(errno)});
+        for (int &wakeFd : d->wakeFds) {
+            if (wakeFd >= 0)
+                ::close(wakeFd);
+            wakeFd = -1;
+        }
+        ::close(fd);
+        ::unlink(socketPath.c_str());
+        return false;
+    }
+
+    d->socketPath = socketPath;
+    d->listenFd = fd;
+    d->stopping = false;
+    for (size_t i = 0; i < d->workerCount; ++i) {
+        d->parsers.push_back(d->schema->createOverlay());
+        if (!d->clientFileAccessAllowed) {
+            d->parsers.back()->setValueFileMode(QCommandLineParser::IgnoreValueFiles);
+            d->parsers.back()->setPositionalArgumentExpansionMode(QCommandLineParser::KeepPositionalArguments);
+        }
+        d->workers.emplace_back(&QCommandLineServerPrivate::work, d, d->parsers.back().get());
+    }
+    d->ioThread = std::thread(&QCommandLineServerPrivate::run, d);
+    return true;
+#else
+    (void)socketPath;
+    qCommandLineWarning({"QCommandLineServer: Unix domain sockets are not supported on this platform"});
+    return false;
+#endif
+}
+
+/*!
+    Stops listening, disconnects all clients and waits for the handlers
+    still running to return.
+*/
+void QCommandLineServer::close()
+{
+#if !defined(_WIN32)
+    if (d->listenFd < 0)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        d->stopping = true;
+    }
+    d->condition.notify_all();
+    d->wake();
+
+    // The I/O thread disconnects the clients on its way out.
+    d->ioThread.join();
+    for (std::thread &worker : d->workers)
+        worker.join();
+    d->workers.clear();
+    d->parsers.clear();
+    d->requests.clear();
+    d->replies.clear();
+    for (int &wakeFd : d->wakeFds) {
+        ::close(wakeFd);
+        wakeFd = -1;
+    }
+    ::close(d->listenFd);
+    d->listenFd = -1;
+    ::unlink(d->socketPath.c_str());
+#endif
+}
+
+bool QCommandLineServer::isListening() const
+{
+    return d->listenFd >= 0;
+}
+
+class QCommandLineClientPrivate
+{
+public:
+    QCommandLineClientPrivate() : fd(-1) { }
+
+    int fd;
+    //! Reused between calls to avoid an allocation per request.
+    std::string frame;
+};
+
+/*!
+    Constructs a client of a QCommandLineServer. Keep the client connected
+    to send many commands over one connection.
+*/
+QCommandLineClient::QCommandLineClient()
+    : d(new QCommandLineClientPrivate)
+{
+}
+
+QCommandLineClient::~QCommandLineClient()
+{
+    disconnectFromServer();
+    delete d;
+}
+
+bool QCommandLineClient::connectToServer(const std::string &socketPath)
+{
+    disconnectFromServer();
+#if !defined(_WIN32)
+    sockaddr_un address;
+    if (!socketAddress(socketPath, &address))
+        return false;
+    d->fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (d->fd < 0 || ::connect(d->fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+        qCommandLineWarning({"QCommandLineClient: cannot connect to \"", socketPath, "\": ", strerror(errno)});
+        disconnectFromServer();
+        return false;
+    }
+    return true;
+#else
+    (void)socketPath;
+    qCommandLineWarning({"QCommandLineClient: Unix domain sockets are not supported on this platform"});
+    return false;
+#endif
+}
+
+void QCommandLineClient::disconnectFromServer()
+{
+#if !defined(_WIN32)
+    if (d->fd >= 0)
+        ::close(d->fd);
+#endif
+    d->fd = -1;
+}
+
+bool QCommandLineClient::isConnected() const
+{
+    return d->fd >= 0;
+}
+
+/*!
+    Sends \a arguments, whose first element is the command name, to the
+    server and waits for the reply, which is stored in \a reply. Returns
+    false and disconnects if the connection fails.
+*/
+bool QCommandLineClient::call(const std::vector<std::string> &arguments, QCommandLineServer::Reply *reply)
+{
+#if !defined(_WIN32)
+    if (d->fd < 0) {
+        qCommandLineWarning({"QCommandLineClient: not connected"});
+        return false;
+    }
+    beginFrame(&d->frame);
+    appendUint32(&d->frame, uint32_t(arguments.size()));
+    for (const std::string &argument : arguments)
+        appendString(&d->frame, argument);
+    endFrame(&d->frame);
+    if (d->frame.size() - 4 > MaximumFrameSize) {
+        qCommandLineWarning({"QCommandLineClient: argument list too large"});
+        return false;
+    }
+    if (!writeFully(d->fd, d->frame) || !readFrame(d->fd, &d->frame)) {
+        disconnectFromServer();
+        return false;
+    }
+
+    PayloadReader reader(d->frame);
+    reply->exitCode = int(reader.readUint32());
+    reply->output = reader.readString();
+    reply->errors.resize(reader.readCount(4));
+    for (std::string &error : reply->errors)
+        error = reader.readString();
+    reply->parseErrors.resize(reader.readCount(ParseErrorSize));
+    for (QCommandLineParser::ParseError &error : reply->parseErrors) {
+        error.kind = QCommandLineParser::ParseErrorKind(reader.readUint32());
+        error.argumentIndex = size_t(reader.readUint64());
+        error.byteOffset = size_t(reader.readUint64());
+        error.length = size_t(reader.readUint64());
+        error.optionOffset = size_t(reader.readUint64());
+        error.detail = size_t(reader.readUint64());
+    }
+    if (!reader.ok) {
+        qCommandLineWarning({"QCommandLineClient: malformed reply"});
+        disconnectFromServer();
+        return false;
+    }
+    return true;
+#else
+    (void)arguments;
+    (void)reply;
+    return false;
+#endif
+}
@@ -0,0 +1,105 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCOMMANDLINESERVER_H
+#define QCOMMANDLINESERVER_H
+
+#include "qcommandlineparser.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class QCommandLineServerPrivate;
+class QCommandLineClientPrivate;
+
+class QCommandLineServer
+{
+public:
+    struct Reply
+    {
+        Reply() : exitCode(0) { }
+
+        int exitCode;
+        std::string output;
+        //! Texts of the parse errors; the handler is not called when there are any.
+        std::vector<std::string> errors;
+        //! The parse errors themselves, in the same order as their texts.
+        std::vector<QCommandLineParser::ParseError> parseErrors;
+    };
+    typedef std::function<Reply(const QCommandLineParser &parser)> Handler;
+
+    explicit QCommandLineServer(const QCommandLineParser &schema);
+    ~QCommandLineServer();
+
+    void setHandler(const std::string &command, const Handler &handler);
+    void setDefaultHandler(const Handler &handler);
+    void setWorkerCount(size_t count);
+    void setSocketPermissions(unsigned int permissions);
+    void setClientFileAccessAllowed(bool allowed);
+
+    bool listen(const std::string &socketPath);
+    void close();
+    bool isListening() const;
+
+private:
+    QCommandLineServer(const QCommandLineServer &) = delete;
+    QCommandLineServer &operator=(const QCommandLineServer &) = delete;
+
+    QCommandLineServerPrivate * const d;
+};
+
+class QCommandLineClient
+{
+public:
+    QCommandLineClient();
+    ~QCommandLineClient();
+
+    bool connectToServer(const std::string &socketPath);
+    void disconnectFromServer();
+    bool isConnected() const;
+
+    bool call(const std::vector<std::string> &arguments, QCommandLineServer::Reply *reply);
+
+private:
+    QCommandLineClient(const QCommandLineClient &) = delete;
+    QCommandLineClient &operator=(const QCommandLineClient &) = delete;
+
+    QCommandLineClientPrivate * const d;
+};
+
+#endif // QCOMMANDLINESERVER_H
@@ -0,0 +1,324 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Copyright (C) 2013 David Faure <faure@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcommandlinesnapshot.h"
+#include "qcommandlinesnapshot_p.h"
+#include "qcommandlineimage_p.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+static const std::vector<std::string_view> noValues;
+
+QCommandLineSnapshot::QCommandLineSnapshot(QCommandLineSnapshotPrivate *dd)
+    : d(dd)
+{
+}
+
+QCommandLineSnapshot::~QCommandLineSnapshot()
+{
+    delete d;
+}
+
+/*!
+    Returns \c true if the option \a name was given on the command line.
+*/
+bool QCommandLineSnapshot::isSet(const std::string &name) const
+{
+    const size_t offset = d->optionTable->find(name);
+    if (offset == std::string::npos)
+        return false;
+    const QCommandLineSnapshotPrivate::Entry *entry = d->entry(offset);
+    return entry && entry->isSet;
+}
+
+/*!
+    Returns the last value of the option \a name, its default value if it was
+    not given, or an empty view if it has neither or is not defined.
+
+    The view stays valid as long as the snapshot.
+*/
+std::string_view QCommandLineSnapshot::value(const std::string &name) const
+{
+    const std::vector<std::string_view> &valueList = values(name);
+    return valueList.empty() ? std::string_view() : valueList.back();
+}
+
+/*!
+    Returns all values of the option \a name, its default values if it was not
+    given, or an empty list if it is not defined.
+*/
+const std::vector<std::string_view> &QCommandLineSnapshot::values(const std::string &name) const
+{
+    const size_t offset = d->optionTable->find(name);
+    return offset == std::string::npos ? noValues : d->values(offset);
+}
+
+const std::vector<std::string_view> &QCommandLineSnapshot::positionalArguments() const
+{
+    return d->positionalArguments;
+}
+
+/*!
+    Serializes the snapshot into a compact, position-independent binary image
+    that QCommandLineImage opens in place, for example from a memfd shared
+    with worker processes. Returns an empty string if the snapshot is too
+    large for the 32-bit offsets of the format.
+*/
+std::string QCommandLineSnapshot::toImage() const
+{
+    using namespace QCommandLineImageFormat;
+
+    std::vector<std::pair<std::string_view, size_t>> names;
+    d->optionTable->forEachName([&names](const NameHash_t::value_type &entry) {
+        names.emplace_back(entry.first, entry.second);
+    });
+    std::sort(names.begin(), names.end());
+
+    const size_t optionCount = d->optionTable->size();
+    size_t stringCount = d->positionalArguments.size();
+    uint64_t bytesSize = 0;
+    for (const auto &name : names)
+        bytesSize += name.first.size();
+    for (size_t offset = 0; offset < optionCount; ++offset) {
+        const std::vector<std::string_view> &values = d->values(offset);
+        stringCount += values.size();
+        for (const std::string_view &value : values)
+            bytesSize += value.size();
+    }
+    for (const std::string_view &argument : d->positionalArguments)
+        bytesSize += argument.size();
+
+    // Laid out in 64 bits first: every count and offset fits the 32-bit
+    // header fields once the whole image does.
+    const uint64_t namesOffset = sizeof(Header);
+    const uint64_t optionsOffset = namesOffset + uint64_t(names.size()) * sizeof(Name);
+    const uint64_t stringsOffset = optionsOffset + uint64_t(optionCount) * sizeof(Option);
+    const uint64_t bytesOffset = stringsOffset + uint64_t(stringCount) * sizeof(String);
+    const uint64_t imageSize = bytesOffset + bytesSize;
+    if (imageSize > std::numeric_limits<uint32_t>::max())
+        return std::string();
+
+    Header header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.nameCount = uint32_t(names.size());
+    header.namesOffset = uint32_t(namesOffset);
+    header.optionCount = uint32_t(optionCount);
+    header.optionsOffset = uint32_t(optionsOffset);
+    header.stringCount = uint32_t(stringCount);
+    header.stringsOffset = uint32_t(stringsOffset);
+    header.positionalCount = uint32_t(d->positionalArguments.size());
+    header.firstPositional = uint32_t(stringCount - d->positionalArguments.size());
+    header.bytesOffset = uint32_t(bytesOffset);
+    header.bytesSize = uint32_t(bytesSize);
+    header.size = uint32_t(imageSize);
+
+    std::string image(header.size, '\0');
+    char *out = &image[0];
+    memcpy(out, &header, sizeof(Header));
+    uint32_t bytesUsed = 0;
+    const auto appendString = [&](std::string_view text) {
+        const String ref = { bytesUsed, uint32_t(text.size()) };
+        memcpy(out + header.bytesOffset + bytesUsed, text.data(), text.size());
+        bytesUsed += uint32_t(text.size());
+        return ref;
+    };
+
+    for (size_t i = 0; i < names.size(); ++i) {
+        const Name entry = { appendString(names.at(i).first), uint32_t(names.at(i).second) };
+        memcpy(out + header.namesOffset + i * sizeof(Name), &entry, sizeof(Name));
+    }
+    uint32_t stringIndex = 0;
+    const auto appendValue = [&](std::string_view text) {
+        const String ref = appendString(text);
+        memcpy(out + header.stringsOffset + stringIndex++ * sizeof(String), &ref, sizeof(String));
+    };
+    for (size_t offset = 0; offset < optionCount; ++offset) {
+        const std::vector<std::string_view> &values = d->values(offset);
+        const QCommandLineSnapshotPrivate::Entry *given = d->entry(offset);
+        const bool isSet = given && given->isSet;
+        const Option entry = { stringIndex, uint32_t(values.size()), isSet };
+        memcpy(out + header.optionsOffset + offset * sizeof(Option), &entry, sizeof(Option));
+        for (const std::string_view &value : values)
+            appendValue(value);
+    }
+    for (const std::string_view &argument : d->positionalArguments)
+        appendValue(argument);
+
+    return image;
+}
+
+class QCommandLineSnapshotPublisherPrivate
+{
+public:
+    enum { ReaderSlotCount = 64 };
+
+    //! Readers currently inside read(), by parity of the grace period they
+    //! entered in. Each thread sticks to one slot, so that readers on
+    //! different threads do not share a cache line.
+    struct alignas(64) ReaderSlot
+    {
+        std::atomic<size_t> readers[2];
+    };
+
+    QCommandLineSnapshotPublisherPrivate()
+        : period(0),
+          published(nullptr)
+    {
+        for (ReaderSlot &slot : slots) {
+            slot.readers[0].store(0, std::memory_order_relaxed);
+            slot.readers[1].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static size_t readerSlot();
+    void synchronize();
+
+    ReaderSlot slots[ReaderSlotCount];
+    std::atomic<size_t> period;
+    std::atomic<const QCommandLineSnapshot *> published;
+
+    //! Serializes publishers and owns the published snapshot.
+    std::mutex writerMutex;
+    std::shared_ptr<const QCommandLineSnapshot> owner;
+};
+
+// static
+size_t QCommandLineSnapshotPublisherPrivate::readerSlot()
+{
+    static std::atomic<size_t> nextSlot(0);
+    thread_local const size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed) % ReaderSlotCount;
+    return slot;
+}
+
+// Waits until no reader can still hold a snapshot published before the call.
+// Two flips are needed: a reader may have sampled the period just before the
+// first one and registered in the old parity after it was drained.
+void QCommandLineSnapshotPublisherPrivate::synchronize()
+{
+    for (int flip = 0; flip < 2; ++flip) {
+        const size_t parity = period.fetch_add(1) & 1;
+        for (ReaderSlot &slot : slots) {
+            while (slot.readers[parity].load() != 0)
+                std::this_thread::yield();
+        }
+    }
+}
+
+QCommandLineSnapshotPublisher::ReadGuard::ReadGuard(std::atomic<size_t> *readers, const QCommandLineSnapshot *snapshot)
+    : readers(readers),
+      snapshot(snapshot)
+{
+}
+
+QCommandLineSnapshotPublisher::ReadGuard::ReadGuard(ReadGuard &&other) noexcept
+    : readers(other.readers),
+      snapshot(other.snapshot)
+{
+    other.readers = nullptr;
+    other.snapshot = nullptr;
+}
+
+QCommandLineSnapshotPublisher::ReadGuard::~ReadGuard()
+{
+    if (readers)
+        readers->fetch_sub(1, std::memory_order_release);
+}
+
+QCommandLineSnapshotPublisher::QCommandLineSnapshotPublisher()
+    : d(new QCommandLineSnapshotPublisherPrivate)
+{
+}
+
+/*!
+    Destroys the publisher and the published snapshot. No ReadGuard may
+    outlive the publisher.
+*/
+QCommandLineSnapshotPublisher::~QCommandLineSnapshotPublisher()
+{
+    delete d;
+}
+
+/*!
+    Returns a guard giving access to the currently published snapshot, or to
+    none if nothing was published yet.
+
+    Reading takes no lock and touches no reference count: the snapshot stays
+    alive until the guard is destroyed because publish() waits for it. Keep
+    guards short-lived, and never call publish() while holding one on the
+    same thread.
+*/
+QCommandLineSnapshotPublisher::ReadGuard QCommandLineSnapshotPublisher::read() const
+{
+    QCommandLineSnapshotPublisherPrivate::ReaderSlot &slot = d->slots[QCommandLineSnapshotPublisherPrivate::readerSlot()];
+    std::atomic<size_t> *readers = &slot.readers[d->period.load() & 1];
+    readers->fetch_add(1);
+    return ReadGuard(readers, d->published.load());
+}
+
+/*!
+    Makes \a snapshot the one returned by read(), typically
+    QCommandLineParser::snapshot() after a reparse().
+
+    Returns once every reader of the previous snapshot has finished, and
+    releases the publisher's reference to it.
+*/
+void QCommandLineSnapshotPublisher::publish(const std::shared_ptr<const QCommandLineSnapshot> &snapshot)
+{
+    std::shared_ptr<const QCommandLineSnapshot> previous;
+    {
+        std::lock_guard<std::mutex> lock(d->writerMutex);
+        previous = d->owner;
+        d->owner = snapshot;
+        d->published.store(snapshot.get());
+        d->synchronize();
+    }
+}
+
+/*!
+    Returns the published snapshot as a shared pointer, for code off the hot path.
+*/
+std::shared_ptr<const QCommandLineSnapshot> QCommandLineSnapshotPublisher::current() const
+{
+    std::lock_guard<std::mutex> lock(d->writerMutex);
+    return d->owner;
+}
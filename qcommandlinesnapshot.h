@@ -0,0 +1,110 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCOMMANDLINESNAPSHOT_H
+#define QCOMMANDLINESNAPSHOT_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class QCommandLineSnapshotPrivate;
+class QCommandLineSnapshotPublisherPrivate;
+
+class QCommandLineSnapshot
+{
+public:
+    ~QCommandLineSnapshot();
+
+    bool isSet(const std::string &name) const;
+    std::string_view value(const std::string &name) const;
+    const std::vector<std::string_view> &values(const std::string &name) const;
+
+    const std::vector<std::string_view> &positionalArguments() const;
+
+    std::string toImage() const;
+
+private:
+    friend class QCommandLineParser;
+    explicit QCommandLineSnapshot(QCommandLineSnapshotPrivate *dd);
+    QCommandLineSnapshot(const QCommandLineSnapshot &) = delete;
+    QCommandLineSnapshot &operator=(const QCommandLineSnapshot &) = delete;
+
+    QCommandLineSnapshotPrivate * const d;
+};
+
+class QCommandLineSnapshotPublisher
+{
+public:
+    class ReadGuard
+    {
+    public:
+        ReadGuard(ReadGuard &&other) noexcept;
+        ~ReadGuard();
+
+        const QCommandLineSnapshot *get() const { return snapshot; }
+        const QCommandLineSnapshot *operator->() const { return snapshot; }
+        const QCommandLineSnapshot &operator*() const { return *snapshot; }
+        explicit operator bool() const { return snapshot != nullptr; }
+
+    private:
+        friend class QCommandLineSnapshotPublisher;
+        ReadGuard(std::atomic<size_t> *readers, const QCommandLineSnapshot *snapshot);
+        ReadGuard(const ReadGuard &) = delete;
+        ReadGuard &operator=(const ReadGuard &) = delete;
+
+        std::atomic<size_t> *readers;
+        const QCommandLineSnapshot *snapshot;
+    };
+
+    QCommandLineSnapshotPublisher();
+    ~QCommandLineSnapshotPublisher();
+
+    ReadGuard read() const;
+    void publish(const std::shared_ptr<const QCommandLineSnapshot> &snapshot);
+    std::shared_ptr<const QCommandLineSnapshot> current() const;
+
+private:
+    QCommandLineSnapshotPublisher(const QCommandLineSnapshotPublisher &) = delete;
+    QCommandLineSnapshotPublisher &operator=(const QCommandLineSnapshotPublisher &) = delete;
+
+    QCommandLineSnapshotPublisherPrivate * const d;
+};
+
+#endif // QCOMMANDLINESNAPSHOT_H
@@ -0,0 +1,100 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCOMMANDLINESNAPSHOT_P_H
+#define QCOMMANDLINESNAPSHOT_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the public API. It is shared between
+// QCommandLineParser and QCommandLineSnapshot and may change without notice.
+//
+
+#include "qcommandlinesnapshot.h"
+#include "qcommandlineoptiontable_p.h"
+
+#include <algorithm>
+
+class QCommandLineSnapshotPrivate
+{
+public:
+    //! The values of an option that was given, or whose defaults had to be
+    //! resolved when the snapshot was taken.
+    struct Entry
+    {
+        size_t offset;
+        bool isSet;
+        std::vector<std::string_view> values;
+    };
+
+    const Entry *entry(size_t offset) const
+    {
+        const auto it = std::lower_bound(entries.cbegin(), entries.cend(), offset,
+                                         [](const Entry &entry, size_t offset) { return entry.offset < offset; });
+        return it != entries.cend() && it->offset == offset ? &*it : nullptr;
+    }
+
+    const std::vector<std::string_view> &values(size_t offset) const
+    {
+        const Entry *found = entry(offset);
+        return found ? found->values : optionTable->defaultValues(offset);
+    }
+
+    //! The options of the parser, shared with it and with other snapshots.
+    //! Their defaults are viewed in place for the options without an entry.
+    std::shared_ptr<const OptionTable> optionTable;
+
+    //! Sorted by offset, so that a snapshot costs as much as the options
+    //! given rather than as many as were defined.
+    std::vector<Entry> entries;
+
+    std::vector<std::string_view> positionalArguments;
+
+    //! Owns the bytes the views above point to. Never resized once views exist.
+    std::string storage;
+
+    //! Own those bytes instead of storage if the parser had a string pool:
+    //! the pool generations the strings were interned in.
+    std::vector<std::shared_ptr<const void>> pooledStrings;
+
+    //! Files mapped for "@path" values, which are viewed in place instead of copied.
+    std::vector<std::shared_ptr<const void>> mappedFiles;
+};
+
+#endif // QCOMMANDLINESNAPSHOT_P_H
@@ -0,0 +1,203 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Copyright (C) 2013 David Faure <faure@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcommandlinestringpool.h"
+
+#include <cstring>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+// Strings are spread over independently locked shards by hash, so that
+// parsers on different threads rarely contend for the same lock.
+static const size_t ShardCount = 16;
+static const size_t BlockSize = 64 * 1024;
+
+class QCommandLineStringPoolPrivate
+{
+public:
+    struct Shard
+    {
+        Shard() : blockPosition(BlockSize), byteCount(0) { }
+
+        const char *store(std::string_view text);
+
+        std::mutex mutex;
+        std::unordered_set<std::string_view> strings;
+        //! Arena owning the bytes of the views in strings; nothing is ever moved.
+        std::vector<std::unique_ptr<char[]>> blocks;
+        //! Strings too large to share a block, each in its own allocation.
+        std::vector<std::unique_ptr<char[]>> largeStrings;
+        size_t blockPosition;
+        size_t byteCount;
+    };
+
+    //! The strings interned since the last trim(). Snapshots keep the
+    //! generations they use alive, so a trimmed generation is freed with the
+    //! last snapshot viewing it. Accessed with std::atomic_load() and
+    //! std::atomic_store() only.
+    struct Generation
+    {
+        Shard shards[ShardCount];
+    };
+
+    std::shared_ptr<Generation> generation;
+};
+
+const char *QCommandLineStringPoolPrivate::Shard::store(std::string_view text)
+{
+    byteCount += text.size();
+    char *data;
+    if (text.size() > BlockSize / 4) {
+        largeStrings.emplace_back(new char[text.size()]);
+        data = largeStrings.back().get();
+    } else {
+        if (blockPosition + text.size() > BlockSize) {
+            blocks.emplace_back(new char[BlockSize]);
+            blockPosition = 0;
+        }
+        data = blocks.back().get() + blockPosition;
+        blockPosition += text.size();
+    }
+    memcpy(data, text.data(), text.size());
+    return data;
+}
+
+/*!
+    Constructs an empty pool.
+
+    A pool stores each distinct string once, so that values repeated across
+    many parses, such as queue names or paths, take memory only once. Strings
+    stay in the pool until trim() is called, and past it for as long as a
+    snapshot uses them. The pool may be shared by parsers on different
+    threads.
+
+    \sa QCommandLineParser::setStringPool()
+*/
+QCommandLineStringPool::QCommandLineStringPool()
+    : d(new QCommandLineStringPoolPrivate)
+{
+    d->generation = std::make_shared<QCommandLineStringPoolPrivate::Generation>();
+}
+
+QCommandLineStringPool::~QCommandLineStringPool()
+{
+    delete d;
+}
+
+/*!
+    Returns the pooled copy of \a text, adding it if needed. Interning equal
+    strings between two calls to trim() returns views with the same data
+    pointer, so interned strings can be compared by pointer. The view is
+    valid until the next trim(), or as long as the pool if it is never
+    trimmed.
+*/
+std::string_view QCommandLineStringPool::intern(std::string_view text)
+{
+    return intern(text, nullptr);
+}
+
+/*!
+    \overload
+
+    Also stores an owner of the bytes of the returned view in \a owner,
+    unless \a owner is null. The view stays valid as long as the owner, even
+    past trim() and the destruction of the pool; owners of strings interned
+    between the same two trims are equal.
+*/
+std::string_view QCommandLineStringPool::intern(std::string_view text, std::shared_ptr<const void> *owner)
+{
+    const std::shared_ptr<QCommandLineStringPoolPrivate::Generation> generation = std::atomic_load(&d->generation);
+    if (owner)
+        *owner = generation;
+    if (text.empty())
+        return std::string_view();
+    const size_t hash = std::hash<std::string_view>()(text);
+    QCommandLineStringPoolPrivate::Shard &shard = generation->shards[(hash >> 8) % ShardCount];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto it = shard.strings.find(text);
+    if (it != shard.strings.cend())
+        return *it;
+    const std::string_view pooled(shard.store(text), text.size());
+    shard.strings.insert(pooled);
+    return pooled;
+}
+
+/*!
+    Empties the pool, so that a long-running process that keeps interning
+    new strings does not grow it without bound.
+
+    The memory of the strings interned so far is released once no owner
+    returned by intern() holds it any more; snapshots hold the owners of the
+    strings they view, so they stay valid. Views obtained without an owner
+    are invalid after this call. Interning a string again after trim() stores
+    a new copy.
+*/
+void QCommandLineStringPool::trim()
+{
+    std::atomic_store(&d->generation, std::make_shared<QCommandLineStringPoolPrivate::Generation>());
+}
+
+/*!
+    Returns the number of distinct strings interned since the last trim().
+*/
+size_t QCommandLineStringPool::size() const
+{
+    const std::shared_ptr<QCommandLineStringPoolPrivate::Generation> generation = std::atomic_load(&d->generation);
+    size_t count = 0;
+    for (QCommandLineStringPoolPrivate::Shard &shard : generation->shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        count += shard.strings.size();
+    }
+    return count;
+}
+
+/*!
+    Returns the total length of the distinct strings interned since the last
+    trim().
+*/
+size_t QCommandLineStringPool::byteCount() const
+{
+    const std::shared_ptr<QCommandLineStringPoolPrivate::Generation> generation = std::atomic_load(&d->generation);
+    size_t count = 0;
+    for (QCommandLineStringPoolPrivate::Shard &shard : generation->shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        count += shard.byteCount;
+    }
+    return count;
+}
@@ -0,0 +1,66 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCOMMANDLINESTRINGPOOL_H
+#define QCOMMANDLINESTRINGPOOL_H
+
+#include <memory>
+#include <string_view>
+
+class QCommandLineStringPoolPrivate;
+
+class QCommandLineStringPool
+{
+public:
+    QCommandLineStringPool();
+    ~QCommandLineStringPool();
+
+    std::string_view intern(std::string_view text);
+    std::string_view intern(std::string_view text, std::shared_ptr<const void> *owner);
+    void trim();
+
+    size_t size() const;
+    size_t byteCount() const;
+
+private:
+    QCommandLineStringPool(const QCommandLineStringPool &) = delete;
+    QCommandLineStringPool &operator=(const QCommandLineStringPool &) = delete;
+
+    QCommandLineStringPoolPrivate * const d;
+};
+
+#endif // QCOMMANDLINESTRINGPOOL_H
@@ -0,0 +1,215 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Copyright (C) 2013 David Faure <faure@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcommandlinetable.h"
+#include "qcommandlinetable_p.h"
+
+#include <bitset>
+
+void QCommandLineTablePrivate::clear()
+{
+    rowCount = 0;
+    optionTable.reset();
+    columns.clear();
+    positionalColumn = QCommandLineTable::Column();
+    positionalColumn.rowOffsets.push_back(0);
+    positionalColumn.valueOffsets.push_back(0);
+    errorColumn = QCommandLineTable::ErrorColumn();
+    errorColumn.rowOffsets.push_back(0);
+}
+
+// Adds columns for options registered after rows were added; they hold no
+// values in those rows, and so take no space for them.
+void QCommandLineTablePrivate::addColumns(size_t count)
+{
+    while (columns.size() < count) {
+        QCommandLineTable::Column column;
+        column.rowOffsets.push_back(0);
+        column.valueOffsets.push_back(0);
+        columns.push_back(std::move(column));
+    }
+}
+
+// Marks \a row, which is at or after the last marked row, as having the
+// option of \a column; its values are appended next.
+void QCommandLineTablePrivate::setPresent(QCommandLineTable::Column *column, size_t row)
+{
+    while (column->presence.size() <= row / 64) {
+        // every bit set so far is in an earlier word
+        column->presenceRanks.push_back(column->rowOffsets.size() - 1);
+        column->presence.push_back(0);
+    }
+    column->presence.back() |= uint64_t(1) << (row % 64);
+}
+
+void QCommandLineTablePrivate::appendValues(QCommandLineTable::Column *column, const std::vector<std::string> &values)
+{
+    for (const std::string &value : values) {
+        column->bytes += value;
+        column->valueOffsets.push_back(column->bytes.size());
+    }
+    column->rowOffsets.push_back(column->valueOffsets.size() - 1);
+}
+
+/*!
+    Constructs an empty table. Fill it with
+    QCommandLineParser::parseIntoTable(), one row per argument list.
+
+    The table stores the results of many parses column by column: for every
+    option a presence bitmap, the value offsets of each row it was given in
+    and one buffer
+    with the bytes of all values, plus columns for the positional arguments
+    and the errors. Aggregations such as how often an option is used, or the
+    distribution of its values, are then sequential scans over a few arrays
+    rather than walks over one parser result per row.
+*/
+QCommandLineTable::QCommandLineTable()
+    : d(new QCommandLineTablePrivate)
+{
+}
+
+QCommandLineTable::~QCommandLineTable()
+{
+    delete d;
+}
+
+size_t QCommandLineTable::rowCount() const
+{
+    return d->rowCount;
+}
+
+/*!
+    Returns the number of option columns, which is the number of options
+    known to the parser that filled the table.
+*/
+size_t QCommandLineTable::columnCount() const
+{
+    return d->columns.size();
+}
+
+/*!
+    Returns the index of the column of the option named \a name, which may be
+    any of its names, or std::string::npos.
+*/
+size_t QCommandLineTable::columnIndex(const std::string &name) const
+{
+    return d->optionTable ? d->optionTable->find(name) : std::string::npos;
+}
+
+/*!
+    Removes all rows and columns.
+*/
+void QCommandLineTable::clear()
+{
+    d->clear();
+}
+
+const QCommandLineTable::Column &QCommandLineTable::column(size_t index) const
+{
+    return d->columns.at(index);
+}
+
+const QCommandLineTable::Column &QCommandLineTable::positionalColumn() const
+{
+    return d->positionalColumn;
+}
+
+const QCommandLineTable::ErrorColumn &QCommandLineTable::errorColumn() const
+{
+    return d->errorColumn;
+}
+
+/*!
+    Returns true if the option of \a column was given in \a row.
+*/
+bool QCommandLineTable::isSet(size_t row, size_t column) const
+{
+    const Column &c = d->columns.at(column);
+    return row < d->rowCount && row / 64 < c.presence.size() && (c.presence[row / 64] >> (row % 64)) & 1;
+}
+
+// Returns the values of the \a index-th row stored in \a column.
+static std::vector<std::string_view> columnValues(const QCommandLineTable::Column &column, size_t index)
+{
+    std::vector<std::string_view> values;
+    if (index + 1 >= column.rowOffsets.size())
+        return values;
+    values.reserve(column.rowOffsets[index + 1] - column.rowOffsets[index]);
+    for (uint64_t i = column.rowOffsets[index]; i < column.rowOffsets[index + 1]; ++i) {
+        values.push_back(std::string_view(column.bytes.data() + column.valueOffsets[i],
+                                          column.valueOffsets[i + 1] - column.valueOffsets[i]));
+    }
+    return values;
+}
+
+/*!
+    Returns the values given in \a row for the option of \a column. Default
+    values are not stored in the table.
+*/
+std::vector<std::string_view> QCommandLineTable::values(size_t row, size_t column) const
+{
+    if (!isSet(row, column))
+        return std::vector<std::string_view>();
+    // the rank of the row among the rows with the option
+    const Column &c = d->columns.at(column);
+    const uint64_t earlierRows = c.presence[row / 64] & ((uint64_t(1) << (row % 64)) - 1);
+    return columnValues(c, c.presenceRanks[row / 64] + std::bitset<64>(earlierRows).count());
+}
+
+std::vector<std::string_view> QCommandLineTable::positionalArguments(size_t row) const
+{
+    return columnValues(d->positionalColumn, row);
+}
+
+/*!
+    Returns the number of parse errors in \a row; 0 means it parsed fine.
+*/
+size_t QCommandLineTable::errorCount(size_t row) const
+{
+    if (row >= d->rowCount)
+        return 0;
+    return d->errorColumn.rowOffsets[row + 1] - d->errorColumn.rowOffsets[row];
+}
+
+/*!
+    Returns the number of rows in which the option of \a column was given.
+*/
+size_t QCommandLineTable::setCount(size_t column) const
+{
+    return d->columns.at(column).rowOffsets.size() - 1;
+}
@@ -0,0 +1,106 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCOMMANDLINETABLE_H
+#define QCOMMANDLINETABLE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class QCommandLineTablePrivate;
+
+class QCommandLineTable
+{
+public:
+    //! The values of one option, or the positional arguments, of all rows.
+    struct Column
+    {
+        //! One bit per row, set when the option was given; unused for
+        //! positionals. Words after the last row with the option are omitted.
+        std::vector<uint64_t> presence;
+        //! The number of bits set in the presence words before each word.
+        std::vector<uint64_t> presenceRanks;
+        //! The values of the k-th row the option was given in are values
+        //! rowOffsets[k] to rowOffsets[k + 1] - 1, so rows without the option
+        //! take no space. For positionals, k is the row itself.
+        std::vector<uint64_t> rowOffsets;
+        //! Value i is the bytes from valueOffsets[i] to valueOffsets[i + 1].
+        std::vector<uint64_t> valueOffsets;
+        std::string bytes;
+    };
+
+    //! The parse errors of all rows.
+    struct ErrorColumn
+    {
+        //! The errors of row r are errors rowOffsets[r] to rowOffsets[r + 1] - 1.
+        std::vector<uint64_t> rowOffsets;
+        //! QCommandLineParser::ParseErrorKind of each error.
+        std::vector<uint8_t> kinds;
+        //! Option column of each error, or UINT32_MAX if no option is involved.
+        std::vector<uint32_t> columns;
+    };
+
+    QCommandLineTable();
+    ~QCommandLineTable();
+
+    size_t rowCount() const;
+    size_t columnCount() const;
+    size_t columnIndex(const std::string &name) const;
+    void clear();
+
+    const Column &column(size_t index) const;
+    const Column &positionalColumn() const;
+    const ErrorColumn &errorColumn() const;
+
+    bool isSet(size_t row, size_t column) const;
+    std::vector<std::string_view> values(size_t row, size_t column) const;
+    std::vector<std::string_view> positionalArguments(size_t row) const;
+    size_t errorCount(size_t row) const;
+
+    size_t setCount(size_t column) const;
+
+private:
+    friend class QCommandLineParser;
+    QCommandLineTable(const QCommandLineTable &) = delete;
+    QCommandLineTable &operator=(const QCommandLineTable &) = delete;
+
+    QCommandLineTablePrivate * const d;
+};
+
+#endif // QCOMMANDLINETABLE_H
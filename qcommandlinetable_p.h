@@ -0,0 +1,76 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCOMMANDLINETABLE_P_H
+#define QCOMMANDLINETABLE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the public API. It is shared between
+// QCommandLineParser and QCommandLineTable and may change without notice.
+//
+
+#include "qcommandlinetable.h"
+#include "qcommandlineoptiontable_p.h"
+
+#include <memory>
+#include <unordered_map>
+
+class QCommandLineTablePrivate
+{
+public:
+    QCommandLineTablePrivate() { clear(); }
+
+    void clear();
+    void addColumns(size_t count);
+    static void setPresent(QCommandLineTable::Column *column, size_t row);
+    static void appendValues(QCommandLineTable::Column *column, const std::vector<std::string> &values);
+
+    size_t rowCount;
+
+    //! The options of the parser filling the table; column indexes are option offsets.
+    std::shared_ptr<const OptionTable> optionTable;
+
+    //! One column per option, indexed by the option's registration offset.
+    std::vector<QCommandLineTable::Column> columns;
+    QCommandLineTable::Column positionalColumn;
+    QCommandLineTable::ErrorColumn errorColumn;
+};
+
+#endif // QCOMMANDLINETABLE_P_H
@@ -0,0 +1,127 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCOMMANDLINETEST_H
+#define QCOMMANDLINETEST_H
+
+//
+//  Minimal test harness shared by the tst_*.cpp programs in this directory.
+//  Each program is built against the library sources and returns non-zero
+//  when any check fails, e.g.:
+//
+//      g++ -std=c++17 -pthread -I.. ../qcommandline*.cpp tst_qcommandlineparser.cpp
+//
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace QCommandLineTest {
+
+inline int &failureCount()
+{
+    static int count = 0;
+    return count;
+}
+
+inline void fail(const char *file, int line, const std::string &message)
+{
+    std::fprintf(stderr, "FAIL! %s:%d: %s\n", file, line, message.c_str());
+    ++failureCount();
+}
+
+inline std::string toString(const std::string &value) { return '"' + value + '"'; }
+inline std::string toString(std::string_view value) { return toString(std::string(value)); }
+inline std::string toString(const char *value) { return toString(std::string(value)); }
+inline std::string toString(bool value) { return value ? "true" : "false"; }
+template <typename T>
+inline std::string toString(const T &value) { return std::to_string(value); }
+template <typename T>
+inline std::string toString(const std::vector<T> &values)
+{
+    std::string result = "(";
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i > 0)
+            result += ", ";
+        result += toString(values.at(i));
+    }
+    return result + ")";
+}
+
+template <typename Actual, typename Expected>
+inline bool compare(const Actual &actual, const Expected &expected, const char *actualText,
+                    const char *expectedText, const char *file, int line)
+{
+    if (actual == expected)
+        return true;
+    fail(file, line, std::string("Compared values are not the same\n   Actual   (") + actualText + "): "
+         + toString(actual) + "\n   Expected (" + expectedText + "): " + toString(expected));
+    return false;
+}
+
+//! Runs each named test function in order and reports the totals.
+inline int run(const char *program, const std::vector<std::pair<const char *, std::function<void()>>> &tests)
+{
+    for (const auto &test : tests) {
+        const int failuresBefore = failureCount();
+        test.second();
+        std::printf("%s: %s::%s()\n", failureCount() == failuresBefore ? "PASS   " : "FAIL!  ", program, test.first);
+    }
+    std::printf("Totals: %d tests, %d failures\n", int(tests.size()), failureCount());
+    return failureCount() == 0 ? 0 : 1;
+}
+
+} // namespace QCommandLineTest
+
+#define QVERIFY(statement) \
+    do { \
+        if (!(statement)) { \
+            QCommandLineTest::fail(__FILE__, __LINE__, "'" #statement "' returned FALSE."); \
+            return; \
+        } \
+    } while (false)
+
+#define QCOMPARE(actual, expected) \
+    do { \
+        if (!QCommandLineTest::compare(actual, expected, #actual, #expected, __FILE__, __LINE__)) \
+            return; \
+    } while (false)
+
+#endif // QCOMMANDLINETEST_H
@@ -0,0 +1,184 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Copyright (C) 2013 David Faure <faure@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcommandlinetest.h"
+
+#include "../qcommandlinediagnostics.h"
+#include "../qcommandlineparser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Everything written to \a file so far, read without moving its position.
+static std::string contents(FILE *file)
+{
+    fflush(file);
+    std::string result;
+    char buffer[4096];
+    ssize_t count;
+    while ((count = ::pread(fileno(file), buffer, sizeof(buffer), off_t(result.size()))) > 0)
+        result.append(buffer, size_t(count));
+    return result;
+}
+
+static size_t lineCount(const std::string &text)
+{
+    return size_t(std::count(text.begin(), text.end(), '\n'));
+}
+
+// Waits up to a second for \a file to contain \a text, without flushing the sink.
+static bool eventuallyContains(FILE *file, const std::string &text)
+{
+    for (int i = 0; i < 100; ++i) {
+        if (contents(file).find(text) != std::string::npos)
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+static void rateLimit()
+{
+    FILE *output = tmpfile();
+    QVERIFY(output);
+    {
+        QCommandLineRingBufferSink sink(output, 1024, 10);
+        for (int i = 0; i < 50; ++i)
+            sink.warning("burst");
+        // a new second may start within the burst and admit ten more
+        const size_t dropped = sink.droppedCount();
+        QVERIFY(dropped >= 30 && dropped <= 40);
+        sink.flush();
+        const std::string text = contents(output);
+        QCOMPARE(lineCount(text), 50 - dropped + 1);
+        QVERIFY(text.find(std::to_string(dropped) + " diagnostic messages dropped") != std::string::npos);
+    }
+    fclose(output);
+}
+
+static void dropsWhenFull()
+{
+    FILE *output = tmpfile();
+    QVERIFY(output);
+    {
+        QCommandLineRingBufferSink sink(output, 4, 1000);
+        for (int i = 0; i < 10; ++i)
+            sink.warning("message " + std::to_string(i));
+        // the drain thread waits for a burst to collect before emptying the buffer
+        QCOMPARE(sink.droppedCount(), size_t(6));
+        // the drops are reported without another warning or a flush
+        QVERIFY(eventuallyContains(output, "6 diagnostic messages dropped"));
+        const std::string text = contents(output);
+        QVERIFY(text.find("message 3\n") != std::string::npos);
+        QCOMPARE(text.find("message 4\n"), std::string::npos);
+        QCOMPARE(lineCount(text), size_t(5));
+    }
+    fclose(output);
+}
+
+class CountingSink : public QCommandLineDiagnosticSink
+{
+public:
+    void warning(std::string_view) override { ++count; }
+    int count = 0;
+};
+
+static void silencedGlobalSink()
+{
+    QCommandLineParser parser;
+    QVERIFY(parser.parse({ "app" }));
+    QVERIFY(QCommandLineDiagnosticSink::globalSink() == QCommandLineDiagnosticSink::defaultSink());
+
+    CountingSink counting;
+    QCommandLineDiagnosticSink::setGlobalSink(&counting);
+    parser.value("undefined");
+    QCOMPARE(counting.count, 1);
+
+    QCommandLineDiagnosticSink::setGlobalSink(nullptr);
+    QVERIFY(!QCommandLineDiagnosticSink::globalSink());
+    parser.value("undefined");
+    QCOMPARE(counting.count, 1);
+
+    QCommandLineDiagnosticSink::setGlobalSink(QCommandLineDiagnosticSink::defaultSink());
+}
+
+static void forkedChildWritesWarnings()
+{
+    FILE *output = tmpfile();
+    QVERIFY(output);
+    {
+        QCommandLineRingBufferSink sink(output, 64, 1000);
+        sink.warning("before fork");
+        QVERIFY(eventuallyContains(output, "before fork\n"));
+
+        const pid_t child = ::fork();
+        QVERIFY(child >= 0);
+        if (child == 0) {
+            // the drain thread of the parent does not exist here
+            sink.warning("from child");
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            ::_exit(0);
+        }
+        int status = 0;
+        QCOMPARE(::waitpid(child, &status, 0), child);
+        QVERIFY(WIFEXITED(status));
+        sink.warning("from parent");
+        sink.flush();
+    }
+    const std::string text = contents(output);
+    QVERIFY(text.find("from child\n") != std::string::npos);
+    QVERIFY(text.find("from parent\n") != std::string::npos);
+    // the child does not write what the parent had queued
+    QCOMPARE(lineCount(text), size_t(3));
+    fclose(output);
+}
+
+int main()
+{
+    return QCommandLineTest::run("tst_QCommandLineDiagnostics", {
+        { "rateLimit", rateLimit },
+        { "dropsWhenFull", dropsWhenFull },
+        { "silencedGlobalSink", silencedGlobalSink },
+        { "forkedChildWritesWarnings", forkedChildWritesWarnings },
+    });
+}
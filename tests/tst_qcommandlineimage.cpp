@@ -0,0 +1,108 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Copyright (C) 2013 David Faure <faure@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcommandlinetest.h"
+
+#include "../qcommandlineimage.h"
+#include "../qcommandlineimage_p.h"
+#include "../qcommandlineparser.h"
+#include "../qcommandlinesnapshot.h"
+
+#include <cstring>
+
+using namespace QCommandLineImageFormat;
+
+static std::string makeImage()
+{
+    QCommandLineParser parser;
+    parser.addOption(QCommandLineOption("define", "Defines a macro.", "macro"));
+    parser.addOption(QCommandLineOption("verbose", "Verbose output."));
+    if (!parser.parse({ "app", "--define", "A", "--define", "B", "--verbose", "input" }))
+        return std::string();
+    return parser.snapshot()->toImage();
+}
+
+static void readBack()
+{
+    const std::string data = makeImage();
+    const QCommandLineImage image(data.data(), data.size());
+    QVERIFY(image.isValid());
+    QVERIFY(image.isSet("verbose"));
+    QCOMPARE(image.value("define"), std::string_view("B"));
+    QCOMPARE(image.values("define").size(), size_t(2));
+    QCOMPARE(image.positionalArguments().size(), size_t(1));
+    QCOMPARE(image.positionalArguments().front(), std::string_view("input"));
+}
+
+static void corruptValueCounts()
+{
+    const std::string data = makeImage();
+    Header header;
+    QVERIFY(data.size() >= sizeof(Header));
+    memcpy(&header, data.data(), sizeof(Header));
+    QVERIFY(header.optionCount > 0);
+
+    const uint32_t corruptions[][2] = {
+        { 0, 0xffffffffu },                   // count far beyond the image
+        { 0xfffffff0u, 0x20u },               // first value beyond the strings
+        { 0, header.stringCount + 1 },        // one past the string table
+    };
+    for (const auto &corruption : corruptions) {
+        std::string corrupt = data;
+        for (uint32_t i = 0; i < header.optionCount; ++i) {
+            Option entry;
+            char *position = &corrupt[header.optionsOffset + i * sizeof(Option)];
+            memcpy(&entry, position, sizeof(Option));
+            entry.firstValue = corruption[0];
+            entry.valueCount = corruption[1];
+            memcpy(position, &entry, sizeof(Option));
+        }
+        const QCommandLineImage image(corrupt.data(), corrupt.size());
+        QVERIFY(image.isValid());
+        QVERIFY(image.values("define").empty());
+        QCOMPARE(image.value("define"), std::string_view());
+    }
+}
+
+int main()
+{
+    return QCommandLineTest::run("tst_QCommandLineImage", {
+        { "readBack", readBack },
+        { "corruptValueCounts", corruptValueCounts },
+    });
+}
@@ -0,0 +1,1070 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Copyright (C) 2013 David Faure <faure@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcommandlinetest.h"
+
+#include "../qcommandlineparser.h"
+#include "../qcommandlinesnapshot.h"
+#include "../qcommandlinestringpool.h"
+#include "../qcommandlinetable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Textbook dynamic-programming Levenshtein distance used as the reference.
+static size_t levenshtein(const std::string &a, const std::string &b)
+{
+    std::vector<size_t> row(b.length() + 1);
+    for (size_t j = 0; j <= b.length(); ++j)
+        row[j] = j;
+    for (size_t i = 1; i <= a.length(); ++i) {
+        size_t diagonal = row[0];
+        row[0] = i;
+        for (size_t j = 1; j <= b.length(); ++j) {
+            const size_t above = row[j];
+            row[j] = std::min({ above + 1, row[j - 1] + 1, diagonal + (a[i - 1] == b[j - 1] ? 0 : 1) });
+            diagonal = above;
+        }
+    }
+    return row[b.length()];
+}
+
+static size_t suggestionDistanceLimit(const std::string &query)
+{
+    return query.length() <= 4 ? 1 : query.length() <= 8 ? 2 : 3;
+}
+
+static bool isSuggested(const std::string &optionName, const std::string &query)
+{
+    QCommandLineParser parser;
+    parser.addOption(QCommandLineOption(optionName));
+    const std::vector<std::string> candidates = parser.suggestions(query);
+    return std::find(candidates.cbegin(), candidates.cend(), optionName) != candidates.cend();
+}
+
+static void suggestionsShiftedNames()
+{
+    struct Case { const char *optionName; const char *query; };
+    const Case cases[] = {
+        { "zabc", "abcd" },           // shifted right by one: distance 2
+        { "bcde", "abcd" },           // shifted left by one: distance 2
+        { "abcd", "abcdx" },          // appended suffix: distance 1
+        { "xabcd", "abcd" },          // prepended prefix: distance 1
+        { "xxabcdefgh", "abcdefgh" }, // two-character prefix: distance 2
+        { "abcdefghxyz", "abcdefgh" },// three-character suffix: distance 3
+        { "xyzabcdefgh", "abcdefgh" },// three-character prefix: distance 3
+        { "output", "outpt" },
+        { "verbose", "verbsoe" },
+    };
+    for (const Case &c : cases) {
+        const bool expected = levenshtein(c.query, c.optionName) <= suggestionDistanceLimit(c.query);
+        QCOMPARE(isSuggested(c.optionName, c.query), expected);
+    }
+    QVERIFY(!isSuggested("zabc", "abcd"));
+    QVERIFY(isSuggested("xabcd", "abcd"));
+}
+
+static void suggestionsMatchLevenshtein()
+{
+    // small alphabet, so that many pairs fall around the distance limit
+    uint32_t seed = 12345;
+    auto next = [&seed]() { seed = seed * 1103515245u + 12345u; return seed >> 16; };
+    auto randomWord = [&next](size_t minLength, size_t maxLength) {
+        std::string word(minLength + next() % (maxLength - minLength + 1), 'a');
+        for (char &c : word)
+            c = char('a' + next() % 3);
+        return word;
+    };
+    for (int i = 0; i < 4000; ++i) {
+        const std::string optionName = randomWord(2, 12);
+        std::string query = optionName;
+        // derive most queries from the name by a few random edits
+        const size_t edits = next() % 5;
+        for (size_t e = 0; e < edits; ++e) {
+            const size_t position = query.empty() ? 0 : next() % (query.length() + 1);
+            switch (next() % 3) {
+            case 0: query.insert(position, 1, char('a' + next() % 4)); break;
+            case 1: if (position < query.length()) query.erase(position, 1); break;
+            default: if (position < query.length()) query[position] = char('a' + next() % 4); break;
+            }
+        }
+        if (next() % 4 == 0)
+            query = randomWord(1, 12);
+        if (query.empty() || query == optionName)
+            continue;
+        const bool expected = levenshtein(query, optionName) <= suggestionDistanceLimit(query);
+        if (isSuggested(optionName, query) != expected) {
+            QCOMPARE(optionName + " ~ " + query, std::string(expected ? "suggested" : "not suggested"));
+        }
+    }
+}
+
+static void errorTextForArgumentErrors()
+{
+    QCommandLineParser parser;
+    parser.addOption(QCommandLineOption("output", "Output file.", "file"));
+    QVERIFY(!parser.parse({ "app", "--outptu", "x", "--bogus", "--output" }));
+    const std::vector<QCommandLineParser::ParseError> errors = parser.errors();
+    QCOMPARE(errors.size(), size_t(3));
+    QCOMPARE(parser.errorText(errors.at(0)), std::string("Unknown option 'outptu'. Did you mean '--output'?"));
+    QCOMPARE(parser.errorText(errors.at(1)), std::string("Unknown option 'bogus'."));
+    QCOMPARE(parser.errorText(errors.at(2)), std::string("Missing value after '--output'."));
+
+    // errors of an earlier parse no longer resolve
+    QVERIFY(parser.parse({ "app", "--output", "y" }));
+    QCOMPARE(parser.errorText(errors.at(1)), std::string());
+}
+
+static void repeatedOptionConsumesValue()
+{
+    QCommandLineParser parser;
+    QCommandLineOption out(std::vector<std::string>({ "o", "out" }), "Output file.", "file");
+    out.setOccurrencePolicy(QCommandLineOption::RejectRepeatedOccurrences);
+    parser.addOption(out);
+    const auto onlyRepeatedOption = [&parser]() {
+        const std::vector<QCommandLineParser::ParseError> errors = parser.errors();
+        return errors.size() == 1 && errors.at(0).kind == QCommandLineParser::RepeatedOption;
+    };
+
+    QVERIFY(!parser.parse({ "app", "--out", "a", "--out", "b", "input" }));
+    QVERIFY(onlyRepeatedOption());
+    QCOMPARE(parser.positionalArguments(), std::vector<std::string>({ "input" }));
+    QCOMPARE(parser.value("out"), std::string("a"));
+    QCOMPARE(parser.occurrenceCount("out"), size_t(2));
+
+    QVERIFY(!parser.parse({ "app", "--out=a", "--out=b", "input" }));
+    QVERIFY(onlyRepeatedOption());
+    QCOMPARE(parser.positionalArguments(), std::vector<std::string>({ "input" }));
+
+    // the compacted form takes the rest of the argument, or the next one
+    QVERIFY(!parser.parse({ "app", "-oa", "-oxyz", "input" }));
+    QVERIFY(onlyRepeatedOption());
+    QCOMPARE(parser.positionalArguments(), std::vector<std::string>({ "input" }));
+    QCOMPARE(parser.value("out"), std::string("a"));
+
+    QVERIFY(!parser.parse({ "app", "-oa", "-o", "b", "input" }));
+    QVERIFY(onlyRepeatedOption());
+    QCOMPARE(parser.positionalArguments(), std::vector<std::string>({ "input" }));
+
+    parser.setSingleDashWordOptionMode(QCommandLineParser::ParseAsLongOptions);
+    QVERIFY(!parser.parse({ "app", "-out", "a", "-out", "b", "input" }));
+    QVERIFY(onlyRepeatedOption());
+    QCOMPARE(parser.positionalArguments(), std::vector<std::string>({ "input" }));
+
+    // a repetition without its value is reported once, not as a missing value too
+    QVERIFY(!parser.parse({ "app", "-out", "a", "-out" }));
+    QVERIFY(onlyRepeatedOption());
+}
+
+struct ProcessResult
+{
+    int exitCode;
+    std::string output;
+};
+
+// process() exits, so run it in a child and collect its exit code and output.
+static ProcessResult runProcess(const std::function<void(QCommandLineParser &)> &setup,
+                                const std::vector<std::string> &arguments)
+{
+    int fds[2];
+    if (::pipe(fds) != 0)
+        return { -1, std::string() };
+    const pid_t pid = ::fork();
+    if (pid == 0) {
+        ::dup2(fds[1], STDOUT_FILENO);
+        ::dup2(fds[1], STDERR_FILENO);
+        ::close(fds[0]);
+        ::close(fds[1]);
+        QCommandLineParser parser;
+        setup(parser);
+        parser.process(arguments);
+        std::fflush(nullptr);
+        ::_exit(100);
+    }
+    ::close(fds[1]);
+    std::string output;
+    char buffer[4096];
+    ssize_t count;
+    while ((count = ::read(fds[0], buffer, sizeof(buffer))) > 0)
+        output.append(buffer, size_t(count));
+    ::close(fds[0]);
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    return { WIFEXITED(status) ? WEXITSTATUS(status) : -1, output };
+}
+
+static void processHelpWithRequiredOptions()
+{
+    const auto setup = [](QCommandLineParser &parser) {
+        parser.addHelpOption();
+        parser.addVersionOption();
+        QCommandLineOption input("input", "Input file.", "file");
+        input.setRequired(true);
+        parser.addOption(input);
+        QCommandLineOption output("output", "Output file.", "file");
+        output.setDependencies({ "input" });
+        parser.addOption(output);
+    };
+
+    ProcessResult result = runProcess(setup, { "app", "--help" });
+    QCOMPARE(result.exitCode, 0);
+    QVERIFY(result.output.find("Usage:") != std::string::npos);
+    QVERIFY(result.output.find("Missing required option") == std::string::npos);
+
+    result = runProcess(setup, { "app", "--output", "o", "--help" });
+    QCOMPARE(result.exitCode, 0);
+    QVERIFY(result.output.find("Usage:") != std::string::npos);
+
+    result = runProcess(setup, { "app", "--version" });
+    QCOMPARE(result.exitCode, 0);
+    QVERIFY(result.output.find("Missing required option") == std::string::npos);
+
+    // without --help the constraints still apply
+    result = runProcess(setup, { "app" });
+    QCOMPARE(result.exitCode, 1);
+    QVERIFY(result.output.find("Missing required option '--input'") != std::string::npos);
+
+    // a malformed command line is still an error
+    result = runProcess(setup, { "app", "--help", "--bogus" });
+    QCOMPARE(result.exitCode, 1);
+    QVERIFY(result.output.find("Unknown option 'bogus'") != std::string::npos);
+
+    result = runProcess(setup, { "app", "--input", "i" });
+    QCOMPARE(result.exitCode, 100);
+}
+
+static void overlaysShareOptions()
+{
+    QCommandLineParser base;
+    QCommandLineOption input("input", "Input file.", "file");
+    input.setRequired(true);
+    base.addOption(input);
+    QCommandLineOption verbose("verbose", "Verbose output.");
+    verbose.setDependencies({ "log" }); // only defined by the overlay
+    base.addOption(verbose);
+    base.addOption(QCommandLineOption("version-file", "Version file.", "file"));
+    base.setLongOptionMatchingMode(QCommandLineParser::MatchUniqueLongOptionPrefixes);
+
+    std::unique_ptr<QCommandLineParser> overlay = base.createOverlay();
+    QVERIFY(overlay->addOption(QCommandLineOption("log", "Log file.", "file")));
+    QVERIFY(overlay->addOption(QCommandLineOption("verify", "Verify output.")));
+    QVERIFY(overlay->addMutuallyExclusiveOptions({ "verify", "verbose" }));
+
+    QVERIFY(overlay->parse({ "app", "--input", "i", "--log", "l", "--verbose" }));
+    QVERIFY(!overlay->parse({ "app", "--input", "i", "--verbose" }));
+    QCOMPARE(overlay->errors().front().kind, QCommandLineParser::MissingDependency);
+    QVERIFY(!overlay->parse({ "app", "--input", "i", "--verify", "--verbose", "--log", "l" }));
+    QCOMPARE(overlay->errors().front().kind, QCommandLineParser::ConflictingOptions);
+    QVERIFY(!overlay->parse({ "app" }));
+    QCOMPARE(overlay->errors().front().kind, QCommandLineParser::MissingRequiredOption);
+
+    // prefixes and suggestions see the options of both layers
+    QVERIFY(overlay->parse({ "app", "--inp", "i", "--lo", "l" }));
+    QCOMPARE(overlay->value("input"), std::string("i"));
+    QVERIFY(!overlay->parse({ "app", "--input", "i", "--ver" }));
+    QCOMPARE(overlay->errorText(overlay->errors().front()),
+             std::string("Ambiguous option 'ver', could be: --verbose, --verify, --version-file."));
+    QCOMPARE(overlay->suggestions("verfiy"), std::vector<std::string>({ "verify" }));
+
+    // the base is not affected by its overlays, and options added to it
+    // later are not seen by them
+    QVERIFY(!base.parse({ "app", "--input", "i", "--log", "l" }));
+    QVERIFY(base.addOption(QCommandLineOption("log", "Base log.", "file")));
+    QVERIFY(base.parse({ "app", "--input", "i", "--log", "l", "--verbose" }));
+    QVERIFY(!overlay->parse({ "app", "--input", "i", "--log", "l", "--verify", "--verbose" }));
+    QVERIFY(!base.parse({ "app", "--input", "i", "--verify" }));
+}
+
+static void overlayCostIndependentOfBase()
+{
+    const auto timePerOverlay = [](size_t baseSize) {
+        QCommandLineParser base;
+        for (size_t i = 0; i < baseSize; ++i) {
+            QCommandLineOption option("option-" + std::to_string(i), "An option.", "value");
+            // a fixed number of missing required options, so that the errors do not grow
+            option.setRequired(i % (baseSize / 4) == 0);
+            base.addOption(option);
+        }
+        base.addMutuallyExclusiveOptions({ "option-1", "option-2" });
+        // warm up the shared structures once
+        base.createOverlay()->parse({ "app", "--optoin-1" });
+
+        const int overlays = 200;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < overlays; ++i) {
+            std::unique_ptr<QCommandLineParser> overlay = base.createOverlay();
+            overlay->addOption(QCommandLineOption("extra", "Extra option."));
+            overlay->parse({ "app", "--extra", "--option-1", "x", "--optoin-2" });
+            overlay->errorText();
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / overlays;
+    };
+    double small = timePerOverlay(500);
+    double large = timePerOverlay(64000);
+    // retry once to ride out a noisy machine
+    if (large > 16 * small) {
+        small = timePerOverlay(500);
+        large = timePerOverlay(64000);
+    }
+    // 128 times the options: the per-parse bit sets grow, but nothing is rebuilt
+    QVERIFY(large < 16 * small);
+}
+
+static void valueFromFile()
+{
+    char path[] = "/tmp/tst_qcommandlineparser_XXXXXX";
+    const int fd = ::mkstemp(path);
+    QVERIFY(fd >= 0);
+    const std::string contents = "-----BEGIN CERTIFICATE-----\n";
+    QVERIFY(::write(fd, contents.data(), contents.size()) == ssize_t(contents.size()));
+    ::close(fd);
+
+    QCommandLineParser parser;
+    QCommandLineOption cert(std::vector<std::string>({ "c", "cert" }), "Certificate.", "file");
+    cert.setValueFromFileAllowed(true);
+    parser.addOption(cert);
+
+    QVERIFY(parser.parse({ "app", "--cert", std::string("@") + path }));
+    QCOMPARE(parser.valueView("cert"), std::string_view(contents));
+    QVERIFY(parser.parse({ "app", std::string("-c@") + path, "--cert=@@literal" }));
+    QCOMPARE(parser.values("cert"), std::vector<std::string>({ contents, "@literal" }));
+    ::unlink(path);
+
+    // files without a size are read rather than mapped
+    QVERIFY(parser.parse({ "app", "--cert=@/proc/self/status" }));
+    QVERIFY(parser.value("cert").find("Name:") != std::string::npos);
+
+    int fds[2];
+    QVERIFY(::pipe(fds) == 0);
+    QVERIFY(::write(fds[1], "hello-secret", 12) == 12);
+    ::close(fds[1]);
+    QVERIFY(parser.parse({ "app", "--cert", "@/dev/fd/" + std::to_string(fds[0]) }));
+    QCOMPARE(parser.value("cert"), std::string("hello-secret"));
+    ::close(fds[0]);
+
+    // by default files are only opened when read, so parsing never fails or blocks on them
+    QVERIFY(parser.parse({ "app", "--cert", "@/nonexistent/cert.pem" }));
+    QCOMPARE(parser.value("cert"), std::string());
+
+    // files without a size are read up to a limit
+    parser.setValueFileMode(QCommandLineParser::ReadValueFilesWhileParsing);
+    QVERIFY(!parser.parse({ "app", "--cert=@/dev/zero" }));
+    QCOMPARE(parser.errorText(parser.errors().front()),
+             std::string("Cannot read value file '/dev/zero' for option '-c': File too large."));
+
+    // when reading while parsing, unreadable files are errors on the argument naming them
+    QVERIFY(!parser.parse({ "app", "--cert", "@/nonexistent/cert.pem" }));
+    QCOMPARE(parser.errors().size(), size_t(1));
+    const QCommandLineParser::ParseError error = parser.errors().front();
+    QCOMPARE(error.kind, QCommandLineParser::InvalidValue);
+    QCOMPARE(error.argumentIndex, size_t(2));
+    QCOMPARE(parser.errorText(error),
+             std::string("Cannot read value file '/nonexistent/cert.pem' for option '-c': No such file or directory."));
+
+    QVERIFY(!parser.parse({ "app", "-c@/nonexistent" }));
+    QCOMPARE(parser.errors().front().byteOffset, size_t(3));
+    QVERIFY(parser.values("cert").empty());
+    QVERIFY(!parser.parse({ "app", "--cert=@/" }));
+    QCOMPARE(parser.errorText(parser.errors().front()),
+             std::string("Cannot read value file '/' for option '-c': Is a directory."));
+
+    parser.setValueFileMode(QCommandLineParser::IgnoreValueFiles);
+    QVERIFY(parser.parse({ "app", "--cert", "@/etc/passwd" }));
+    QCOMPARE(parser.value("cert"), std::string("@/etc/passwd"));
+}
+
+// The matches of "**/*.txt" below \a directory in the documented order:
+// names sorted within a directory, a directory before its contents.
+static void expectedTextFiles(const std::string &directory, std::vector<std::string> *result)
+{
+    std::vector<std::filesystem::directory_entry> entries{ std::filesystem::directory_iterator(directory),
+                                                           std::filesystem::directory_iterator() };
+    std::sort(entries.begin(), entries.end(), [](const std::filesystem::directory_entry &a,
+                                                 const std::filesystem::directory_entry &b) {
+        return a.path().filename().string() < b.path().filename().string();
+    });
+    for (const std::filesystem::directory_entry &entry : entries) {
+        const std::string name = entry.path().filename().string();
+        if (name[0] == '.')
+            continue;
+        if (entry.is_directory())
+            expectedTextFiles(directory + name + '/', result);
+        else if (name.size() > 4 && name.compare(name.size() - 4, 4, ".txt") == 0)
+            result->push_back(directory + name);
+    }
+}
+
+static void globMatchesStreamedInOrder()
+{
+    const std::string root = (std::filesystem::temp_directory_path() / "tst_qcommandlineglob").string() + '/';
+    std::filesystem::remove_all(root);
+    // more files than the walk holds back, spread over nested directories
+    for (int i = 0; i < 120; ++i) {
+        const std::string directory = root + "d" + std::to_string(i * 7919 % 120) + "/n" + std::to_string(i % 3) + '/';
+        std::filesystem::create_directories(directory);
+        for (int j = 0; j < 700; ++j)
+            std::ofstream(directory + "f" + std::to_string(j) + (j % 5 ? ".txt" : ".log"));
+        std::ofstream(directory + ".hidden.txt");
+    }
+    std::filesystem::create_directories(root + ".skipped");
+    std::ofstream(root + ".skipped/f.txt");
+    std::ofstream(root + "top.txt");
+
+    std::vector<std::string> expected;
+    expectedTextFiles(root, &expected);
+    QVERIFY(expected.size() > 65536);
+
+    QCommandLineParser parser;
+    parser.setPositionalArgumentExpansionMode(QCommandLineParser::ExpandGlobPatterns);
+    std::vector<std::string> matches;
+    parser.setGlobMatchHandler([&matches](const std::string &path) { matches.push_back(path); });
+    QVERIFY(parser.parse({ "app", root + "**/*.txt", "literal" }));
+    QCOMPARE(parser.positionalArguments(), std::vector<std::string>({ "literal" }));
+    QCOMPARE(matches.size(), expected.size());
+    QVERIFY(matches == expected);
+
+    // a throwing handler stops the walk and leaves the parser usable
+    size_t calls = 0;
+    parser.setGlobMatchHandler([&calls](const std::string &) {
+        if (++calls == 10)
+            throw std::runtime_error("enough");
+    });
+    bool thrown = false;
+    try {
+        parser.parse({ "app", root + "**/*.txt" });
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+    QCOMPARE(calls, size_t(10));
+
+    parser.setGlobMatchHandler(QCommandLineParser::GlobMatchHandler());
+    QVERIFY(parser.parse({ "app", root + "d1*/n?/f1.txt" }));
+    // d1, d10 to d19 and d100 to d119
+    QCOMPARE(parser.positionalArguments().size(), size_t(31));
+    std::filesystem::remove_all(root);
+}
+
+static void stringPoolTrim()
+{
+    std::shared_ptr<QCommandLineStringPool> pool = std::make_shared<QCommandLineStringPool>();
+    QCommandLineParser parser;
+    parser.setStringPool(pool);
+    parser.addOption(QCommandLineOption("queue", "Queue.", "name"));
+    QVERIFY(parser.parse({ "app", "--queue", "batch", "input" }));
+    const std::shared_ptr<const QCommandLineSnapshot> before = parser.snapshot();
+    QCOMPARE(pool->size(), size_t(2));
+    QCOMPARE(pool->byteCount(), size_t(10));
+
+    pool->trim();
+    QCOMPARE(pool->size(), size_t(0));
+    QCOMPARE(pool->byteCount(), size_t(0));
+    const std::shared_ptr<const QCommandLineSnapshot> after = parser.snapshot();
+    QCOMPARE(pool->size(), size_t(2));
+    QVERIFY(after->value("queue").data() != before->value("queue").data());
+
+    // snapshots keep their strings past the trim and the pool itself
+    parser.setStringPool(nullptr);
+    pool.reset();
+    QCOMPARE(before->value("queue"), std::string_view("batch"));
+    QCOMPARE(before->positionalArguments().at(0), std::string_view("input"));
+    QCOMPARE(after->value("queue"), std::string_view("batch"));
+
+    // a trimmed generation is freed with its last owner
+    QCommandLineStringPool local;
+    std::shared_ptr<const void> owner;
+    const std::string_view view = local.intern("payload", &owner);
+    QVERIFY(local.intern("payload").data() == view.data());
+    const std::weak_ptr<const void> generation = owner;
+    local.trim();
+    QVERIFY(!generation.expired());
+    QCOMPARE(view, std::string_view("payload"));
+    QVERIFY(local.intern("payload").data() != view.data());
+    owner.reset();
+    QVERIFY(generation.expired());
+}
+
+static void snapshotViewsDefaults()
+{
+    char path[] = "/tmp/tst_qcommandlineparser_XXXXXX";
+    const int fd = ::mkstemp(path);
+    QVERIFY(fd >= 0);
+    QVERIFY(::write(fd, "key", 3) == 3);
+    ::close(fd);
+
+    QCommandLineParser parser;
+    QCommandLineOption level("level", "Level.", "n");
+    level.setDefaultValues({ "3", "4" });
+    parser.addOption(level);
+    parser.addOption(QCommandLineOption("verbose", "Verbose."));
+    QCommandLineOption key("key", "Key.", "file");
+    key.setValueFromFileAllowed(true);
+    key.setDefaultValue(std::string("@") + path);
+    parser.addOption(key);
+    QVERIFY(parser.parse({ "app", "--verbose" }));
+
+    std::shared_ptr<const QCommandLineSnapshot> snapshot = parser.snapshot();
+    QVERIFY(snapshot->isSet("verbose"));
+    QVERIFY(!snapshot->isSet("level"));
+    QCOMPARE(snapshot->values("level"), std::vector<std::string_view>({ "3", "4" }));
+    QCOMPARE(snapshot->value("key"), std::string_view("key"));
+    QVERIFY(!snapshot->isSet("key"));
+
+    // options added after the snapshot do not change it
+    parser.addOption(QCommandLineOption("later", "Later.", "x", "default"));
+    QVERIFY(parser.parse({ "app", "--level", "5" }));
+    QCOMPARE(snapshot->values("level"), std::vector<std::string_view>({ "3", "4" }));
+    QCOMPARE(snapshot->value("later"), std::string_view());
+    snapshot = parser.snapshot();
+    QCOMPARE(snapshot->values("level"), std::vector<std::string_view>({ "5" }));
+    QCOMPARE(snapshot->value("later"), std::string_view("default"));
+    ::unlink(path);
+}
+
+static void snapshotCostIndependentOfOptions()
+{
+    const auto timePerSnapshot = [](size_t optionCount) {
+        QCommandLineParser parser;
+        for (size_t i = 0; i < optionCount; ++i)
+            parser.addOption(QCommandLineOption("option-" + std::to_string(i), "An option.", "value", "default"));
+        parser.parse({ "app", "--option-1", "x", "--option-2", "y", "input" });
+        parser.snapshot(); // warm up the shared defaults once
+
+        const int snapshots = 2000;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < snapshots; ++i)
+            parser.snapshot();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / snapshots;
+    };
+    double small = timePerSnapshot(500);
+    double large = timePerSnapshot(64000);
+    // retry once to ride out a noisy machine
+    if (large > 4 * small) {
+        small = timePerSnapshot(500);
+        large = timePerSnapshot(64000);
+    }
+    // 128 times the options, but only the given ones are copied
+    QVERIFY(large < 4 * small);
+}
+
+static void tableStoresPresentRowsOnly()
+{
+    QCommandLineParser parser;
+    parser.addOption(QCommandLineOption("rare", "Rare.", "x"));
+    parser.addOption(QCommandLineOption("flag", "Flag."));
+    QCommandLineTable table;
+    for (int row = 0; row < 1000; ++row) {
+        if (row % 100 == 7)
+            QVERIFY(parser.parseIntoTable(&table, { "app", "--rare", std::to_string(row), "--rare", "again", "--flag" }));
+        else
+            QVERIFY(parser.parseIntoTable(&table, { "app", "p" + std::to_string(row) }));
+    }
+    const size_t rare = table.columnIndex("rare");
+    const size_t flag = table.columnIndex("flag");
+    QCOMPARE(table.setCount(rare), size_t(10));
+    QCOMPARE(table.setCount(flag), size_t(10));
+    QCOMPARE(table.column(rare).rowOffsets.size(), size_t(11));
+    QCOMPARE(table.column(rare).valueOffsets.size(), size_t(21));
+    for (size_t row = 0; row < 1000; ++row) {
+        const bool given = row % 100 == 7;
+        const std::string value = std::to_string(row);
+        QCOMPARE(table.isSet(row, rare), given);
+        QCOMPARE(table.isSet(row, flag), given);
+        QCOMPARE(table.values(row, rare), given ? std::vector<std::string_view>({ value, "again" })
+                                                : std::vector<std::string_view>());
+        QVERIFY(table.values(row, flag).empty());
+    }
+    QCOMPARE(table.positionalArguments(8), std::vector<std::string_view>({ "p8" }));
+
+    // a column added after many rows takes no space for them
+    parser.addOption(QCommandLineOption("late", "Late.", "x"));
+    QVERIFY(parser.parseIntoTable(&table, { "app", "--late", "v" }));
+    const size_t late = table.columnIndex("late");
+    QCOMPARE(table.column(late).rowOffsets.size(), size_t(2));
+    QVERIFY(!table.isSet(5, late));
+    QVERIFY(table.isSet(1000, late));
+    QCOMPARE(table.values(1000, late), std::vector<std::string_view>({ "v" }));
+    QVERIFY(!table.isSet(1000, rare));
+}
+
+static void tableRejectsMismatchedOverlays()
+{
+    QCommandLineParser base;
+    base.addOption(QCommandLineOption("common", "Common.", "x"));
+    const std::unique_ptr<QCommandLineParser> alpha = base.createOverlay();
+    alpha->addOption(QCommandLineOption("alpha", "Alpha."));
+    const std::unique_ptr<QCommandLineParser> beta = base.createOverlay();
+    beta->addOption(QCommandLineOption("beta", "Beta."));
+
+    QCommandLineTable table;
+    QVERIFY(alpha->parseIntoTable(&table, { "app", "--alpha" }));
+    QVERIFY(base.parseIntoTable(&table, { "app", "--common", "c" }));
+    QCOMPARE(table.columnIndex("alpha"), size_t(1));
+
+    // beta would land in the column of alpha
+    QVERIFY(!beta->parseIntoTable(&table, { "app", "--beta" }));
+    QCOMPARE(table.rowCount(), size_t(2));
+    QCOMPARE(table.columnIndex("beta"), std::string::npos);
+
+    // an overlay adding the same option fits
+    const std::unique_ptr<QCommandLineParser> again = base.createOverlay();
+    again->addOption(QCommandLineOption("alpha", "Alpha again."));
+    QVERIFY(again->parseIntoTable(&table, { "app", "--alpha" }));
+    QVERIFY(table.isSet(2, 1));
+    QCOMPARE(table.setCount(1), size_t(2));
+}
+
+static void reparseCallsChangedHandlers()
+{
+    QCommandLineParser parser;
+    const QCommandLineOption verbose("verbose", "Verbose.");
+    const QCommandLineOption level("level", "Level.", "level");
+    const QCommandLineOption quiet("quiet", "Quiet.");
+    parser.addOptions({ verbose, level, quiet });
+    std::vector<std::string> changed;
+    size_t positionalChanges = 0;
+    for (const QCommandLineOption &option : { verbose, level, quiet }) {
+        parser.setOptionChangeHandler(option, [&](const QCommandLineOption &changedOption) {
+            // the handlers see the new state
+            changed.push_back(changedOption.names().front() + "=" + parser.value(changedOption));
+        });
+    }
+    parser.setPositionalArgumentsChangeHandler([&] { ++positionalChanges; });
+
+    QVERIFY(parser.reparse({ "app", "--verbose", "--level=1", "file" }));
+    QCOMPARE(changed, std::vector<std::string>({ "verbose=", "level=1" }));
+    QCOMPARE(positionalChanges, size_t(1));
+
+    // unchanged options and positional arguments call nothing
+    changed.clear();
+    QVERIFY(parser.reparse({ "app", "--level=1", "--verbose", "file" }));
+    QVERIFY(changed.empty());
+    QCOMPARE(positionalChanges, size_t(1));
+
+    // removed, added and revalued options do, in option order
+    QVERIFY(parser.reparse({ "app", "--quiet", "--level=2", "other" }));
+    QCOMPARE(changed, std::vector<std::string>({ "verbose=", "level=2", "quiet=" }));
+    QCOMPARE(positionalChanges, size_t(2));
+
+    // a repeated flag changes its occurrence count
+    changed.clear();
+    QVERIFY(parser.reparse({ "app", "--quiet", "--quiet", "--level=2", "other" }));
+    QCOMPARE(changed, std::vector<std::string>({ "quiet=" }));
+
+    // an empty handler removes it
+    changed.clear();
+    parser.setOptionChangeHandler(level, QCommandLineParser::OptionChangeHandler());
+    QVERIFY(parser.reparse({ "app", "--quiet", "--quiet", "--level=3", "other" }));
+    QVERIFY(changed.empty());
+}
+
+static void reparseFailureKeepsPreviousResults()
+{
+    char path[] = "/tmp/tst_qcommandlineparser_XXXXXX";
+    const int fd = ::mkstemp(path);
+    QVERIFY(fd >= 0);
+    QVERIFY(::write(fd, "secret", 6) == 6);
+    ::close(fd);
+
+    QCommandLineParser parser;
+    QCommandLineOption cert("cert", "Certificate.", "file");
+    cert.setValueFromFileAllowed(true);
+    QCommandLineOption level("level", "Level.", "level", "5");
+    parser.addOptions({ cert, level });
+    size_t calls = 0;
+    parser.setOptionChangeHandler(cert, [&](const QCommandLineOption &) { ++calls; });
+    parser.setPositionalArgumentsChangeHandler([&] { ++calls; });
+
+    QVERIFY(parser.parse({ "app", "--cert", std::string("@") + path, "--bogus", "file" }) == false);
+    QVERIFY(parser.reparse({ "app", "--cert", std::string("@") + path, "file" }));
+    calls = 0;
+    const std::string_view contents = parser.valueView("cert");
+    const std::string_view defaultLevel = parser.valueView("level");
+    QCOMPARE(contents, std::string_view("secret"));
+    ::unlink(path);
+
+    QVERIFY(!parser.reparse({ "app", "--unknown", "other", "--cert" }));
+    QCOMPARE(calls, size_t(0));
+    QCOMPARE(parser.errors().size(), size_t(2));
+    QCOMPARE(parser.errorText(), std::string("Missing value after '--cert'.\nUnknown option 'unknown'."));
+
+    // the previous results stay, and views into them stay valid
+    QVERIFY(parser.unknownOptionNames().empty());
+    QCOMPARE(parser.positionalArguments(), std::vector<std::string>({ "file" }));
+    QCOMPARE(parser.valueView("cert").data(), contents.data());
+    QCOMPARE(contents, std::string_view("secret"));
+    QCOMPARE(parser.valueView("level").data(), defaultLevel.data());
+    QCOMPARE(parser.optionNames(), std::vector<std::string>({ "cert" }));
+
+    // and the next reparse compares against them
+    QVERIFY(parser.reparse({ "app", "--cert", "@@plain", "file" }));
+    QCOMPARE(calls, size_t(1));
+    QCOMPARE(parser.value("cert"), std::string("@plain"));
+}
+
+// Terminal columns of \a line for the characters used below: combining
+// acute accents take none, CJK ideographs two, and invalid bytes one each.
+static size_t columns(const std::string &line)
+{
+    size_t width = 0;
+    for (size_t i = 0; i < line.size(); ) {
+        const unsigned char lead = line[i];
+        if (lead == 0xcc && i + 1 < line.size() && (unsigned char)line[i + 1] == 0x81) {
+            i += 2;
+        } else if (lead >= 0xe4 && lead <= 0xe9 && i + 2 < line.size()) {
+            width += 2;
+            i += 3;
+        } else if (lead >= 0xc2 && lead < 0xe0 && i + 1 < line.size()) {
+            width += 1;
+            i += 2;
+        } else {
+            width += 1;
+            i += 1;
+        }
+    }
+    return width;
+}
+
+// The lines of the help text of a parser with the single option \a name
+// described by \a description, starting at the option.
+static std::vector<std::string> optionHelpLines(const std::string &name, const std::string &description)
+{
+    QCommandLineParser parser;
+    parser.addOption(QCommandLineOption(name, description));
+    const std::string help = parser.helpText();
+    std::vector<std::string> lines;
+    for (size_t start = help.find("\n  ") + 1, end; start < help.size(); start = end + 1) {
+        end = help.find('\n', start);
+        lines.push_back(help.substr(start, end - start));
+    }
+    return lines;
+}
+
+// Strips the name column from the lines of optionHelpLines() and joins them.
+static std::string joinedDescription(const std::vector<std::string> &lines, size_t indent)
+{
+    std::string result;
+    for (const std::string &line : lines)
+        result += line.substr(indent);
+    return result;
+}
+
+static void helpTextWrapsUtf8()
+{
+    // one column per byte, broken at the last space that fits
+    std::vector<std::string> lines = optionHelpLines("ascii", std::string(30, 'a') + " " + std::string(100, 'b'));
+    QCOMPARE(lines.size(), size_t(3));
+    QCOMPARE(lines[0], "  --ascii  " + std::string(30, 'a'));
+    QCOMPARE(lines[1], std::string(11, ' ') + std::string(68, 'b'));
+    QCOMPARE(lines[2], std::string(11, ' ') + std::string(32, 'b'));
+
+    // forced breaks come first, even on a full line
+    lines = optionHelpLines("ascii", std::string(68, 'a') + "\nb");
+    QCOMPARE(lines.size(), size_t(2));
+    QCOMPARE(lines[1], std::string(11, ' ') + "b");
+
+    // wide characters take two columns and are never split
+    std::string wide;
+    for (int i = 0; i < 50; ++i)
+        wide += "\xe6\xbc\xa2";
+    lines = optionHelpLines("ascii", wide);
+    QCOMPARE(lines.size(), size_t(2));
+    QCOMPARE(columns(lines[0]), size_t(11 + 68));
+    QCOMPARE(columns(lines[1]), size_t(11 + 32));
+    QCOMPARE(joinedDescription(lines, 11), wide);
+
+    // combining marks take no column and stay with their base character
+    std::string combining;
+    for (int i = 0; i < 100; ++i)
+        combining += "e\xcc\x81";
+    lines = optionHelpLines("ascii", combining);
+    QCOMPARE(lines.size(), size_t(2));
+    QCOMPARE(columns(lines[0]), size_t(79));
+    QCOMPARE(lines[1].substr(11, 1), std::string("e"));
+    QCOMPARE(joinedDescription(lines, 11), combining);
+
+    // invalid bytes take a column each and are kept as they are
+    const std::string invalid = std::string(60, 'a') + " \xff\xfe\xc3 " + std::string(20, 'b');
+    lines = optionHelpLines("ascii", invalid);
+    QCOMPARE(lines.size(), size_t(2));
+    QCOMPARE(lines[0].substr(11), std::string(60, 'a') + " \xff\xfe\xc3");
+    QCOMPARE(lines[1].substr(11), std::string(20, 'b'));
+
+    // a name of a single code point is a short option, in help and when parsing
+    lines = optionHelpLines("\xc3\xbc", "Umlaut.");
+    QCOMPARE(lines[0], std::string("  -\xc3\xbc  Umlaut."));
+    QCommandLineParser parser;
+    parser.addOption(QCommandLineOption("\xc3\xbc", "Umlaut."));
+    parser.addOption(QCommandLineOption("v", "Verbose."));
+    QVERIFY(parser.parse({ "app", "-v\xc3\xbc" }));
+    QVERIFY(parser.isSet("\xc3\xbc"));
+    QVERIFY(parser.isSet("v"));
+}
+
+static void longOptionPrefixes()
+{
+    QCommandLineParser parser;
+    parser.addOption(QCommandLineOption("verbose", "Verbose output."));
+    parser.addOption(QCommandLineOption("version-file", "Version file.", "file"));
+    parser.addOption(QCommandLineOption(std::vector<std::string>({ "output", "output-file" }), "Output.", "file"));
+    parser.addOption(QCommandLineOption("out", "Out."));
+
+    // exact matching is the default
+    QVERIFY(!parser.parse({ "app", "--verb" }));
+    QCOMPARE(parser.errors().front().kind, QCommandLineParser::UnknownOption);
+
+    // a unique prefix stands for its option, with or without a value
+    parser.setLongOptionMatchingMode(QCommandLineParser::MatchUniqueLongOptionPrefixes);
+    QVERIFY(parser.parse({ "app", "--verb", "--versi", "v.txt", "positional" }));
+    QVERIFY(parser.isSet("verbose"));
+    QCOMPARE(parser.value("version-file"), std::string("v.txt"));
+    QCOMPARE(parser.positionalArguments(), std::vector<std::string>({ "positional" }));
+    QVERIFY(parser.parse({ "app", "--versi=v.txt" }));
+    QCOMPARE(parser.value("version-file"), std::string("v.txt"));
+
+    // aliases of one option sharing the prefix are not ambiguous
+    QVERIFY(parser.parse({ "app", "--outp", "o.txt" }));
+    QCOMPARE(parser.value("output"), std::string("o.txt"));
+
+    // an exact name wins over the longer names it is a prefix of
+    QVERIFY(parser.parse({ "app", "--out", "positional" }));
+    QVERIFY(parser.isSet("out"));
+    QVERIFY(!parser.isSet("output"));
+    QCOMPARE(parser.positionalArguments(), std::vector<std::string>({ "positional" }));
+
+    // an ambiguous prefix is an error listing the candidates, and takes the
+    // value one of them would have
+    QVERIFY(!parser.parse({ "app", "--ver", "value", "positional" }));
+    QCOMPARE(parser.errors().size(), size_t(1));
+    const QCommandLineParser::ParseError error = parser.errors().front();
+    QCOMPARE(error.kind, QCommandLineParser::AmbiguousOption);
+    QCOMPARE(error.argumentIndex, size_t(1));
+    QCOMPARE(error.byteOffset, size_t(2));
+    QCOMPARE(error.length, size_t(3));
+    QCOMPARE(parser.errorText(error), std::string("Ambiguous option 'ver', could be: --verbose, --version-file."));
+    QCOMPARE(parser.positionalArguments(), std::vector<std::string>({ "positional" }));
+    QVERIFY(!parser.parse({ "app", "--ver=value", "positional" }));
+    QCOMPARE(parser.positionalArguments(), std::vector<std::string>({ "positional" }));
+
+    // the same applies to long options written with one dash
+    parser.setSingleDashWordOptionMode(QCommandLineParser::ParseAsLongOptions);
+    QVERIFY(parser.parse({ "app", "-verb" }));
+    QVERIFY(parser.isSet("verbose"));
+    QVERIFY(!parser.parse({ "app", "-ver", "value", "positional" }));
+    QCOMPARE(parser.errors().front().byteOffset, size_t(1));
+    QCOMPARE(parser.positionalArguments(), std::vector<std::string>({ "positional" }));
+}
+
+static void constraintsFollowOptionChanges()
+{
+    QCommandLineParser parser;
+    QCommandLineOption level("level", "Level.", "level");
+    QCommandLineOption input("input", "Input.", "file");
+    parser.addOptions({ level, input });
+    std::unique_ptr<QCommandLineParser> overlay = parser.createOverlay();
+    QVERIFY(parser.parse({ "app", "--level=50" }));
+    QVERIFY(overlay->parse({ "app", "--level=50" }));
+
+    // the copies given to the parser share the options, so changes made
+    // after parsing apply to the next parse of the parser and its overlays
+    input.setRequired(true);
+    QVERIFY(!parser.parse({ "app", "--level=50" }));
+    QCOMPARE(parser.errors().front().kind, QCommandLineParser::MissingRequiredOption);
+    QVERIFY(!overlay->parse({ "app", "--level=50" }));
+    input.setRequired(false);
+    QVERIFY(parser.parse({ "app", "--level=50" }));
+
+    level.setValueRange(0, 10);
+    QVERIFY(!parser.parse({ "app", "--level=50" }));
+    QCOMPARE(parser.errors().front().kind, QCommandLineParser::ValueOutOfRange);
+    level.setAllowedValues({ "1", "2" });
+    QVERIFY(!parser.parse({ "app", "--level=3" }));
+    QCOMPARE(parser.errors().front().kind, QCommandLineParser::InvalidValue);
+    QVERIFY(parser.parse({ "app", "--level=2" }));
+
+    // an empty range is rejected and keeps the previous one
+    level.setValueRange(10, 5);
+    QCOMPARE(level.minimumValue(), 0LL);
+    QCOMPARE(level.maximumValue(), 10LL);
+    QCommandLineOption fresh("fresh", "Fresh.", "value");
+    fresh.setValueRange(1, 0);
+    QVERIFY(!fresh.hasValueRange());
+}
+
+static void helpGroupsAndLazyDescriptions()
+{
+    QCommandLineParser parser;
+    size_t pluginCalls = 0;
+    size_t codecCalls = 0;
+    QCommandLineOption verbose("verbose", "Verbose output.");
+    QCommandLineOption plugin("plugin", "", "name");
+    plugin.setGroup("Plugins");
+    plugin.setDescriptionProvider([&] { ++pluginCalls; return std::string("One of: a, b."); });
+    QCommandLineOption codec(std::vector<std::string>({ "c", "codec-with-a-long-name" }), "", "codec");
+    codec.setGroup("Codecs");
+    codec.setDescriptionProvider([&] { ++codecCalls; return std::string("Codec."); });
+    QCommandLineOption pluginPath("plugin-path", "Plugin directory.", "dir");
+    pluginPath.setGroup("Plugins");
+    QCommandLineOption secret("secret", "Hidden.");
+    secret.setGroup("Secrets");
+    secret.setHidden(true);
+    parser.addOptions({ verbose, plugin, codec, pluginPath, secret });
+
+    // descriptions are not computed while parsing
+    QVERIFY(parser.parse({ "app", "--verbose", "--plugin", "a", "-c", "x" }));
+    QCOMPARE(pluginCalls, size_t(0));
+    QCOMPARE(codecCalls, size_t(0));
+
+    // groups come in the order they first appear, options without one first;
+    // hidden options and the groups left empty by them are not listed
+    QCOMPARE(parser.optionGroups(), std::vector<std::string>({ "Plugins", "Codecs" }));
+    const std::string help = parser.helpText();
+    QCOMPARE(pluginCalls, size_t(1));
+    QCOMPARE(codecCalls, size_t(1));
+    const std::string pad(std::string("-c, --codec-with-a-long-name <codec>").size() + 1, ' ');
+    const std::string options = "Options:\n"
+                                "  --verbose" + pad.substr(9) + " Verbose output.\n";
+    const std::string plugins = "Plugins:\n"
+                                "  --plugin <name>" + pad.substr(15) + " One of: a, b.\n"
+                                "  --plugin-path <dir>" + pad.substr(19) + " Plugin directory.\n";
+    const std::string codecs = "Codecs:\n"
+                               "  -c, --codec-with-a-long-name <codec>  Codec.\n";
+    QCOMPARE(help, "Usage: [executable name] [options]\n\n" + options + "\n" + plugins + "\n" + codecs);
+
+    // one group is laid out as in the full help, and only its descriptions are computed
+    QCOMPARE(parser.helpText("Plugins"), plugins);
+    QCOMPARE(pluginCalls, size_t(2));
+    QCOMPARE(codecCalls, size_t(1));
+    QCOMPARE(parser.helpText(""), options);
+    QCOMPARE(pluginCalls, size_t(2));
+    QCOMPARE(parser.helpText("Secrets"), std::string());
+    QCOMPARE(parser.helpText("Nonexistent"), std::string());
+
+    // setDescription() replaces the provider
+    plugin.setDescription("Plugin.");
+    QVERIFY(parser.helpText("Plugins").find("--plugin <name>" + pad.substr(15) + " Plugin.\n") != std::string::npos);
+    QCOMPARE(pluginCalls, size_t(2));
+}
+
+static void publisherConcurrentReads()
+{
+    QCommandLineParser parser;
+    parser.addOption(QCommandLineOption("generation", "Generation.", "n"));
+    QCommandLineSnapshotPublisher publisher;
+    QVERIFY(!publisher.read());
+
+    QVERIFY(parser.parse({ "app", "--generation=0", "0" }));
+    std::shared_ptr<const QCommandLineSnapshot> snapshot = parser.snapshot();
+    publisher.publish(snapshot);
+    const std::weak_ptr<const QCommandLineSnapshot> first = snapshot;
+    snapshot.reset();
+    QVERIFY(!first.expired());
+
+    std::atomic<bool> done(false);
+    std::atomic<size_t> failures(0);
+    std::atomic<size_t> reads(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            long last = 0;
+            while (!done.load()) {
+                const QCommandLineSnapshotPublisher::ReadGuard guard = publisher.read();
+                // a snapshot is never torn or freed while read, and never older than one read before
+                const std::string value(guard->value("generation"));
+                const long generation = std::stol(value);
+                if (guard->positionalArguments().size() != 1 || guard->positionalArguments().front() != value
+                        || generation < last)
+                    ++failures;
+                last = generation;
+                ++reads;
+            }
+        });
+    }
+    for (int generation = 1; generation <= 200; ++generation) {
+        const std::string text = std::to_string(generation);
+        QVERIFY(parser.reparse({ "app", "--generation=" + text, text }));
+        publisher.publish(parser.snapshot());
+        // the previous snapshot is released once its readers are done
+        QVERIFY(first.expired());
+    }
+    while (reads.load() < 1000)
+        std::this_thread::yield();
+    done = true;
+    for (std::thread &reader : readers)
+        reader.join();
+    QCOMPARE(failures.load(), size_t(0));
+    QCOMPARE(publisher.read()->value("generation"), std::string_view("200"));
+    QCOMPARE(publisher.current()->positionalArguments().front(), std::string_view("200"));
+}
+
+int main()
+{
+    return QCommandLineTest::run("tst_QCommandLineParser", {
+        { "suggestionsShiftedNames", suggestionsShiftedNames },
+        { "suggestionsMatchLevenshtein", suggestionsMatchLevenshtein },
+        { "errorTextForArgumentErrors", errorTextForArgumentErrors },
+        { "repeatedOptionConsumesValue", repeatedOptionConsumesValue },
+        { "processHelpWithRequiredOptions", processHelpWithRequiredOptions },
+        { "overlaysShareOptions", overlaysShareOptions },
+        { "valueFromFile", valueFromFile },
+        { "globMatchesStreamedInOrder", globMatchesStreamedInOrder },
+        { "stringPoolTrim", stringPoolTrim },
+        { "snapshotViewsDefaults", snapshotViewsDefaults },
+        { "snapshotCostIndependentOfOptions", snapshotCostIndependentOfOptions },
+        { "tableStoresPresentRowsOnly", tableStoresPresentRowsOnly },
+        { "tableRejectsMismatchedOverlays", tableRejectsMismatchedOverlays },
+        { "overlayCostIndependentOfBase", overlayCostIndependentOfBase },
+        { "reparseCallsChangedHandlers", reparseCallsChangedHandlers },
+        { "reparseFailureKeepsPreviousResults", reparseFailureKeepsPreviousResults },
+        { "helpTextWrapsUtf8", helpTextWrapsUtf8 },
+        { "longOptionPrefixes", longOptionPrefixes },
+        { "constraintsFollowOptionChanges", constraintsFollowOptionChanges },
+        { "helpGroupsAndLazyDescriptions", helpGroupsAndLazyDescriptions },
+        { "publisherConcurrentReads", publisherConcurrentReads },
+    });
+}
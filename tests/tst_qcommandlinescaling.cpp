@@ -0,0 +1,233 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Copyright (C) 2013 David Faure <faure@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcommandlinetest.h"
+
+#include "../qcommandlineparser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+// Counts every allocation of the program, so that the allocations of a
+// scenario can be compared across input sizes independently of timing noise.
+static std::atomic<size_t> allocationCount(0);
+
+void *operator new(size_t size)
+{
+    ++allocationCount;
+    if (void *memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+// Each scenario runs at BaseSize and at 16 times that. Linear work grows 16
+// times, quadratic work 256 times; the limits leave room for noise, for
+// hash tables growing in steps and for the smaller run's fixed costs.
+static const size_t BaseSize = 2000;
+static const size_t Growth = 16;
+static const double MaximumTimeGrowth = 48;
+static const double MaximumAllocationGrowth = 24;
+
+struct Cost
+{
+    double seconds;
+    size_t allocations;
+};
+
+// The best of three runs, to ride out a noisy machine.
+static Cost measure(const std::function<void(size_t)> &scenario, size_t size)
+{
+    Cost best = { 0, 0 };
+    for (int run = 0; run < 3; ++run) {
+        const size_t allocationsBefore = allocationCount.load();
+        const auto start = std::chrono::steady_clock::now();
+        scenario(size);
+        const Cost cost = { std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+                            allocationCount.load() - allocationsBefore };
+        if (run == 0 || cost.seconds < best.seconds)
+            best.seconds = cost.seconds;
+        best.allocations = cost.allocations;
+    }
+    return best;
+}
+
+static void verifyLinear(const std::function<void(size_t)> &scenario)
+{
+    const Cost small = measure(scenario, BaseSize);
+    const Cost large = measure(scenario, Growth * BaseSize);
+    const double timeGrowth = large.seconds / std::max(small.seconds, 1e-4);
+    const double allocationGrowth = double(large.allocations) / std::max<size_t>(small.allocations, 1);
+    if (allocationGrowth > MaximumAllocationGrowth) {
+        QCommandLineTest::fail(__FILE__, __LINE__, "allocations grew " + std::to_string(allocationGrowth)
+                               + " times for " + std::to_string(Growth) + " times the input");
+    }
+    if (timeGrowth > MaximumTimeGrowth) {
+        QCommandLineTest::fail(__FILE__, __LINE__, "time grew " + std::to_string(timeGrowth)
+                               + " times for " + std::to_string(Growth) + " times the input");
+    }
+}
+
+// The generated corpus: argument lists of a given size that stress one
+// kind of input each.
+
+// Flags and valued options given over and over under all their aliases,
+// mixed with unknown options and positional arguments.
+static std::vector<std::string> repeatedOptions(size_t size)
+{
+    std::vector<std::string> arguments({ "app" });
+    for (size_t i = 0; i < size; ++i) {
+        const std::string number = std::to_string(i);
+        arguments.push_back(i % 2 ? "-v" : "--noisy");
+        arguments.push_back("--value=" + number);
+        arguments.push_back("--unknown-" + number);
+        arguments.push_back("input-" + number);
+    }
+    return arguments;
+}
+
+static void addRepeatedOptions(QCommandLineParser *parser)
+{
+    parser->addOption(QCommandLineOption(std::vector<std::string>({ "v", "verbose", "loud", "noisy" }), "Verbose."));
+    parser->addOption(QCommandLineOption("value", "A value.", "value"));
+}
+
+static void parseRepeatedOptions()
+{
+    verifyLinear([](size_t size) {
+        QCommandLineParser parser;
+        addRepeatedOptions(&parser);
+        parser.parse(repeatedOptions(size));
+    });
+}
+
+static void accessorsOfRepeatedOptions()
+{
+    verifyLinear([](size_t size) {
+        QCommandLineParser parser;
+        addRepeatedOptions(&parser);
+        parser.parse(repeatedOptions(size));
+        for (int i = 0; i < 100; ++i) {
+            parser.isSet("loud");
+            parser.value("value");
+            parser.occurrenceCount("noisy");
+        }
+        parser.values("value");
+        parser.optionNames();
+        parser.unknownOptionNames();
+        parser.positionalArguments();
+    });
+}
+
+static void errorTextOfUnknownOptions()
+{
+    verifyLinear([](size_t size) {
+        QCommandLineParser parser;
+        addRepeatedOptions(&parser);
+        parser.parse(repeatedOptions(size));
+        parser.errorText();
+    });
+}
+
+// One compacted argument holding every short option over and over.
+static void compactedShortOptions()
+{
+    verifyLinear([](size_t size) {
+        QCommandLineParser parser;
+        parser.addOption(QCommandLineOption("a", "A."));
+        parser.addOption(QCommandLineOption("b", "B."));
+        std::string argument = "-";
+        for (size_t i = 0; i < size; ++i)
+            argument += i % 3 ? "ab" : "x";
+        parser.parse({ "app", argument });
+        parser.occurrenceCount("a");
+        parser.errorText();
+    });
+}
+
+// A single value as long as the rest of the corpus together.
+static void longValue()
+{
+    verifyLinear([](size_t size) {
+        QCommandLineParser parser;
+        addRepeatedOptions(&parser);
+        parser.parse({ "app", "--value=" + std::string(size * 64, '=') });
+        parser.value("value");
+    });
+}
+
+// Many options with long descriptions, and one description without spaces.
+static void helpTextOfManyOptions()
+{
+    verifyLinear([](size_t size) {
+        QCommandLineParser parser;
+        parser.addOption(QCommandLineOption("blob", std::string(size * 8, 'd')));
+        for (size_t i = 0; i < size / 4; ++i) {
+            const std::string number = std::to_string(i);
+            parser.addOption(QCommandLineOption(std::vector<std::string>({ "o" + number, "option-" + number }),
+                                                "Sets the option number " + number + " to the given value,"
+                                                " which is described at some length here.",
+                                                "value"));
+        }
+        parser.helpText();
+    });
+}
+
+int main()
+{
+    return QCommandLineTest::run("tst_QCommandLineScaling", {
+        { "parseRepeatedOptions", parseRepeatedOptions },
+        { "accessorsOfRepeatedOptions", accessorsOfRepeatedOptions },
+        { "errorTextOfUnknownOptions", errorTextOfUnknownOptions },
+        { "compactedShortOptions", compactedShortOptions },
+        { "longValue", longValue },
+        { "helpTextOfManyOptions", helpTextOfManyOptions },
+    });
+}
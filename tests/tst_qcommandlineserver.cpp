@@ -0,0 +1,283 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Laszlo Papp <lpapp@kde.org>
+** Copyright (C) 2013 David Faure <faure@kde.org>
+** Contact: https://www.qt.io/licensing/
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qcommandlinetest.h"
+
+#include "../qcommandlineparser.h"
+#include "../qcommandlineserver.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include <stdexcept>
+
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static std::string socketPath()
+{
+    return "/tmp/tst_qcommandlineserver_" + std::to_string(::getpid());
+}
+
+static QCommandLineServer::Reply greet(const QCommandLineParser &parser)
+{
+    QCommandLineServer::Reply reply;
+    reply.output = "hello " + parser.value("name");
+    return reply;
+}
+
+static void idleClientsOutnumberWorkers()
+{
+    QCommandLineParser schema;
+    schema.addOption(QCommandLineOption("name", "Name to greet.", "name"));
+    QCommandLineServer server(schema);
+    server.setWorkerCount(2);
+    server.setDefaultHandler(greet);
+    const std::string path = socketPath();
+    ::unlink(path.c_str());
+    QVERIFY(server.listen(path));
+    // a worker tied up by an idle client would hang the calls below
+    ::alarm(60);
+
+    std::vector<std::unique_ptr<QCommandLineClient>> idleClients;
+    for (int i = 0; i < 16; ++i) {
+        idleClients.emplace_back(new QCommandLineClient);
+        QVERIFY(idleClients.back()->connectToServer(path));
+    }
+    QCommandLineClient client;
+    QVERIFY(client.connectToServer(path));
+    QCommandLineServer::Reply reply;
+    QVERIFY(client.call({ "greet", "--name", "first" }, &reply));
+    QCOMPARE(reply.exitCode, 0);
+    QCOMPARE(reply.output, std::string("hello first"));
+
+    // every idle client is still served, by the same two workers
+    for (size_t i = 0; i < idleClients.size(); ++i) {
+        QVERIFY(idleClients.at(i)->call({ "greet", "--name", std::to_string(i) }, &reply));
+        QCOMPARE(reply.output, "hello " + std::to_string(i));
+    }
+
+    QVERIFY(client.call({ "greet", "--bogus" }, &reply));
+    QCOMPARE(reply.exitCode, EXIT_FAILURE);
+    QCOMPARE(reply.errors.size(), size_t(1));
+
+    std::atomic<int> served(0);
+    std::vector<std::thread> callers;
+    for (int t = 0; t < 8; ++t) {
+        callers.emplace_back([&path, &served, t]() {
+            QCommandLineClient caller;
+            if (!caller.connectToServer(path))
+                return;
+            QCommandLineServer::Reply callerReply;
+            for (int i = 0; i < 50; ++i) {
+                const std::string name = std::to_string(t) + '.' + std::to_string(i);
+                if (caller.call({ "greet", "--name", name }, &callerReply) && callerReply.output == "hello " + name)
+                    ++served;
+            }
+        });
+    }
+    for (std::thread &caller : callers)
+        caller.join();
+    QCOMPARE(served.load(), 8 * 50);
+
+    server.close();
+    ::alarm(0);
+    QVERIFY(!client.call({ "greet" }, &reply));
+}
+
+static void oversizedRequestDropsClient()
+{
+    QCommandLineParser schema;
+    schema.addOption(QCommandLineOption("name", "Name to greet.", "name"));
+    QCommandLineServer server(schema);
+    server.setWorkerCount(1);
+    server.setDefaultHandler(greet);
+    const std::string path = socketPath();
+    ::unlink(path.c_str());
+    QVERIFY(server.listen(path));
+    ::alarm(60);
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.data(), path.size());
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    QVERIFY(fd >= 0);
+    QVERIFY(::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0);
+    const unsigned char header[4] = { 0xff, 0xff, 0xff, 0x7f };
+    QVERIFY(::send(fd, header, sizeof(header), 0) == ssize_t(sizeof(header)));
+    char byte;
+    QCOMPARE(::recv(fd, &byte, 1, 0), ssize_t(0));
+    ::close(fd);
+
+    // the server goes on serving others
+    QCommandLineClient client;
+    QVERIFY(client.connectToServer(path));
+    QCommandLineServer::Reply reply;
+    QVERIFY(client.call({ "greet" }, &reply));
+    QCOMPARE(reply.output, std::string("hello "));
+    server.close();
+    ::alarm(0);
+}
+
+static void repliesCarryParseErrors()
+{
+    QCommandLineParser schema;
+    schema.addOption(QCommandLineOption("name", "Name to greet.", "name"));
+    QCommandLineServer server(schema);
+    server.setWorkerCount(1);
+    server.setDefaultHandler(greet);
+    const std::string path = socketPath();
+    ::unlink(path.c_str());
+    QVERIFY(server.listen(path));
+    ::alarm(60);
+
+    QCommandLineClient client;
+    QVERIFY(client.connectToServer(path));
+    QCommandLineServer::Reply reply;
+    QVERIFY(client.call({ "greet", "--nmae=x", "--name" }, &reply));
+    QCOMPARE(reply.exitCode, int(EXIT_FAILURE));
+    QCOMPARE(reply.parseErrors.size(), size_t(2));
+    QCOMPARE(reply.errors.size(), size_t(2));
+    QCOMPARE(reply.parseErrors[0].kind, QCommandLineParser::UnknownOption);
+    QCOMPARE(reply.parseErrors[0].argumentIndex, size_t(1));
+    QCOMPARE(reply.parseErrors[0].optionOffset, size_t(std::string::npos));
+    QCOMPARE(reply.parseErrors[1].kind, QCommandLineParser::MissingValue);
+    QCOMPARE(reply.parseErrors[1].argumentIndex, size_t(2));
+    QCOMPARE(reply.parseErrors[1].optionOffset, size_t(0));
+
+    // a successful reply carries none
+    QVERIFY(client.call({ "greet", "--name=you" }, &reply));
+    QCOMPARE(reply.output, std::string("hello you"));
+    QVERIFY(reply.parseErrors.empty());
+    server.close();
+    ::alarm(0);
+}
+
+static void throwingHandlerReplies()
+{
+    QCommandLineParser schema;
+    QCommandLineServer server(schema);
+    server.setWorkerCount(1);
+    server.setHandler("throw", [](const QCommandLineParser &) -> QCommandLineServer::Reply {
+        throw std::runtime_error("out of cheese");
+    });
+    server.setHandler("throw-int", [](const QCommandLineParser &) -> QCommandLineServer::Reply {
+        throw 42;
+    });
+    const std::string path = socketPath();
+    ::unlink(path.c_str());
+    QVERIFY(server.listen(path));
+    ::alarm(60);
+
+    QCommandLineClient client;
+    QVERIFY(client.connectToServer(path));
+    QCommandLineServer::Reply reply;
+    QVERIFY(client.call({ "throw" }, &reply));
+    QCOMPARE(reply.exitCode, int(EXIT_FAILURE));
+    QCOMPARE(reply.errors, std::vector<std::string>({ "Handler failed: out of cheese" }));
+    // the worker survived and serves the next request
+    QVERIFY(client.call({ "throw-int" }, &reply));
+    QCOMPARE(reply.errors, std::vector<std::string>({ "Handler failed." }));
+    server.close();
+    ::alarm(0);
+}
+
+static void clientsCannotReadServerFiles()
+{
+    QCommandLineParser schema;
+    QCommandLineOption name("name", "Name to greet.", "name");
+    name.setValueFromFileAllowed(true);
+    schema.addOption(name);
+    schema.setValueFileMode(QCommandLineParser::ReadValueFilesWhileParsing);
+    schema.setPositionalArgumentExpansionMode(QCommandLineParser::ExpandGlobPatterns);
+    QCommandLineServer server(schema);
+    server.setWorkerCount(1);
+    server.setDefaultHandler([](const QCommandLineParser &parser) {
+        QCommandLineServer::Reply reply;
+        reply.output = parser.value("name");
+        for (const std::string &argument : parser.positionalArguments())
+            reply.output += " " + argument;
+        return reply;
+    });
+    const std::string path = socketPath();
+    ::unlink(path.c_str());
+    QVERIFY(server.listen(path));
+    ::alarm(60);
+
+    // only the user running the server may connect
+    struct stat status;
+    QVERIFY(::stat(path.c_str(), &status) == 0);
+    QCOMPARE(unsigned(status.st_mode & 0777), 0600u);
+
+    QCommandLineClient client;
+    QVERIFY(client.connectToServer(path));
+    QCommandLineServer::Reply reply;
+    QVERIFY(client.call({ "echo", "--name=@/etc/hostname", "/etc/host*" }, &reply));
+    QCOMPARE(reply.exitCode, 0);
+    QCOMPARE(reply.output, std::string("@/etc/hostname /etc/host*"));
+    server.close();
+
+    // unless file access is allowed explicitly
+    server.setClientFileAccessAllowed(true);
+    server.setSocketPermissions(0660);
+    QVERIFY(server.listen(path));
+    QVERIFY(::stat(path.c_str(), &status) == 0);
+    QCOMPARE(unsigned(status.st_mode & 0777), 0660u);
+    QVERIFY(client.connectToServer(path));
+    QVERIFY(client.call({ "echo", "--name=@/nonexistent" }, &reply));
+    QCOMPARE(reply.exitCode, int(EXIT_FAILURE));
+    QCOMPARE(reply.parseErrors.front().kind, QCommandLineParser::InvalidValue);
+    server.close();
+    ::alarm(0);
+}
+
+int main()
+{
+    return QCommandLineTest::run("tst_QCommandLineServer", {
+        { "idleClientsOutnumberWorkers", idleClientsOutnumberWorkers },
+        { "oversizedRequestDropsClient", oversizedRequestDropsClient },
+        { "repliesCarryParseErrors", repliesCarryParseErrors },
+        { "throwingHandlerReplies", throwingHandlerReplies },
+        { "clientsCannotReadServerFiles", clientsCannotReadServerFiles },
+    });
+}